@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "disk_arena.h"
+
+/* one buffer, free or taken, the arena never shrinks while running */
+struct arena_buf {
+	void *ptr;
+	size_t size;
+	int fill;
+	size_t filled;
+	bool busy;
+	bool mapped;
+	struct arena_buf *next;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	struct arena_buf *bufs;
+	struct arena_stat st;
+} arena = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+void arena_init(int mode)
+{
+	arena.st.mode = mode;
+}
+
+static int arena_alloc(struct arena_buf *b, size_t len, size_t align)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	int mode = arena.st.mode;
+	void *ptr;
+
+	b->mapped = false;
+
+	if (mode == ARENA_ON || (size_t)page < align) {
+		if (posix_memalign(&b->ptr, align, len))
+			return -ENOMEM;
+		b->size = len;
+		return 0;
+	}
+
+	/* mapped in huge page units, the tail is used by larger requests */
+	len = (len + ARENA_HUGE_SIZE - 1) / ARENA_HUGE_SIZE * ARENA_HUGE_SIZE;
+
+	if (mode == ARENA_HUGE) {
+		ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (ptr != MAP_FAILED)
+			goto out;
+
+		fprintf(stderr,
+			"no hugetlb pages for %zu byte (%d), use THP\n",
+			len, errno);
+		arena.st.mode = mode = ARENA_THP;
+	}
+
+	ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ptr == MAP_FAILED)
+		return -ENOMEM;
+
+	madvise(ptr, len, MADV_HUGEPAGE);
+
+out:
+	b->ptr = ptr;
+	b->size = len;
+	b->mapped = true;
+
+	return 0;
+}
+
+/* a released buffer is empty, releasing it again is a no-op */
+static void arena_release(struct arena_buf *b)
+{
+	if (!b->ptr)
+		return;
+
+	if (b->mapped)
+		munmap(b->ptr, b->size);
+	else
+		free(b->ptr);
+	arena.st.bytes -= b->size;
+
+	b->ptr = NULL;
+	b->size = 0;
+	b->mapped = false;
+}
+
+void *arena_get(size_t len, size_t align, int fill, size_t *filled)
+{
+	struct arena_buf *b, *fit = NULL, *small = NULL;
+	void *ptr = NULL;
+
+	*filled = 0;
+
+	pthread_mutex_lock(&arena.lock);
+	arena.st.gets++;
+
+	if (arena.st.mode == ARENA_OFF) {
+		arena.st.allocs++;
+		pthread_mutex_unlock(&arena.lock);
+		return posix_memalign(&ptr, align, len) ? NULL : ptr;
+	}
+
+	/* the kept content first, then the smallest free buffer */
+	for (b = arena.bufs; b; b = b->next) {
+		/* a pattern is kept for the writes, reads take another */
+		if (b->busy || (fill == ARENA_ANY && b->fill != ARENA_ANY))
+			continue;
+
+		if (b->size < len) {
+			small = b;
+			continue;
+		}
+
+		if (fill != ARENA_ANY && b->fill == fill && b->filled) {
+			fit = b;
+			break;
+		}
+
+		if (!fit || b->size < fit->size)
+			fit = b;
+	}
+
+	if (!fit) {
+		/* a larger buffer takes the place of a free smaller one */
+		if (small) {
+			arena_release(small);
+			fit = small;
+		} else {
+			fit = calloc(1, sizeof(*fit));
+			if (!fit)
+				goto out;
+			fit->next = arena.bufs;
+			arena.bufs = fit;
+		}
+
+		if (arena_alloc(fit, len, align)) {
+			fit->ptr = NULL;
+			fit->size = 0;
+			fit = NULL;
+			goto out;
+		}
+
+		fit->fill = ARENA_ANY;
+		fit->filled = 0;
+		arena.st.allocs++;
+		arena.st.bytes += fit->size;
+	} else if (fill == ARENA_ANY) {
+		*filled = fit->size;
+	} else if (fit->fill == fill) {
+		*filled = fit->filled < len ? fit->filled : len;
+		if (*filled == len)
+			arena.st.fills++;
+	}
+
+	fit->busy = true;
+	ptr = fit->ptr;
+
+out:
+	pthread_mutex_unlock(&arena.lock);
+
+	return ptr;
+}
+
+void arena_put(void *buf, int fill, size_t filled)
+{
+	struct arena_buf *b;
+
+	if (!buf)
+		return;
+
+	if (arena.st.mode == ARENA_OFF) {
+		free(buf);
+		return;
+	}
+
+	pthread_mutex_lock(&arena.lock);
+	for (b = arena.bufs; b; b = b->next) {
+		if (b->ptr == buf) {
+			b->busy = false;
+			b->fill = fill;
+			b->filled = fill == ARENA_ANY ? 0 : filled;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&arena.lock);
+}
+
+void arena_stat(struct arena_stat *st)
+{
+	pthread_mutex_lock(&arena.lock);
+	*st = arena.st;
+	pthread_mutex_unlock(&arena.lock);
+}
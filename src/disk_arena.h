@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_ARENA_H_
+#define _DISK_ARENA_H_
+
+#include <stddef.h>
+
+#define	ARENA_OFF		(0)	/* allocate and free every buffer */
+#define	ARENA_ON		(1)
+#define	ARENA_THP		(2)	/* madvise(MADV_HUGEPAGE) */
+#define	ARENA_HUGE		(3)	/* MAP_HUGETLB, THP when none */
+
+#define	ARENA_HUGE_SIZE		(2 * 1024 * 1024)
+
+/* content of a buffer handed back to the arena */
+#define	ARENA_ANY		(0)	/* nothing to keep */
+#define	ARENA_SEQ		(1)	/* words of buf[i] = i */
+
+struct arena_stat {
+	unsigned long long gets;	/* buffer requests */
+	unsigned long long allocs;	/* requests that allocated */
+	unsigned long long fills;	/* requests with the content kept */
+	unsigned long long bytes;	/* held by the arena */
+	int mode;			/* ARENA_xxx in use */
+};
+
+/* process wide, before any buffer is taken */
+void arena_init(int mode);
+
+/*
+ * aligned buffer of 'len' bytes. '*filled' returns the bytes of 'fill'
+ * content the buffer holds already, for ARENA_ANY non zero means an
+ * used buffer with its pages faulted in.
+ */
+void *arena_get(size_t len, size_t align, int fill, size_t *filled);
+
+/* give back 'buf' holding 'filled' bytes of 'fill' content */
+void arena_put(void *buf, int fill, size_t filled);
+
+void arena_stat(struct arena_stat *st);
+
+#endif /* _DISK_ARENA_H_ */
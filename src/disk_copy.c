@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE	/* for splice */
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+
+#include "disk_copy.h"
+
+static const char * const copy_names[COPY_METHODS] = {
+	[COPY_RW] = "read/write",
+	[COPY_CFR] = "copy_file_range",
+	[COPY_SENDFILE] = "sendfile",
+	[COPY_SPLICE] = "splice",
+};
+
+const char *copy_name(int method)
+{
+	return method < COPY_METHODS ? copy_names[method] : "unknown";
+}
+
+static long long copy_rw(int in, int out, long long length,
+			 int chunk, void *buf)
+{
+	long long done = 0;
+	ssize_t ret, w;
+
+	while (length > done) {
+		ret = read(in, buf, length - done > chunk ?
+			   chunk : length - done);
+		if (ret <= 0)
+			return ret < 0 ? -errno : done;
+
+		for (w = 0; ret > w; ) {
+			ssize_t n = write(out, (char *)buf + w, ret - w);
+
+			if (n < 0)
+				return -errno;
+			w += n;
+		}
+		done += ret;
+	}
+
+	return done;
+}
+
+static long long copy_cfr(int in, int out, long long length, int chunk)
+{
+#ifdef __NR_copy_file_range
+	long long done = 0;
+	long ret;
+
+	while (length > done) {
+		ret = syscall(__NR_copy_file_range, in, NULL, out, NULL,
+			      (size_t)(length - done > chunk ?
+			      chunk : length - done), 0);
+		if (ret <= 0)
+			return ret < 0 ? -errno : done;
+		done += ret;
+	}
+
+	return done;
+#else
+	return -ENOSYS;
+#endif
+}
+
+static long long copy_sendfile(int in, int out, long long length, int chunk)
+{
+	long long done = 0;
+	ssize_t ret;
+
+	while (length > done) {
+		ret = sendfile(out, in, NULL, length - done > chunk ?
+			       chunk : length - done);
+		if (ret <= 0)
+			return ret < 0 ? -errno : done;
+		done += ret;
+	}
+
+	return done;
+}
+
+static long long copy_splice(int in, int out, long long length, int chunk)
+{
+	long long done = 0;
+	int pipefd[2], size;
+	ssize_t ret, n;
+
+	if (pipe(pipefd) < 0)
+		return -errno;
+
+	/* pipe-max-size limits the pipe, move at most a pipe at once */
+	size = fcntl(pipefd[1], F_SETPIPE_SZ, chunk);
+	if (size < 0)
+		size = fcntl(pipefd[1], F_GETPIPE_SZ);
+	if (size > 0 && chunk > size)
+		chunk = size;
+
+	while (length > done) {
+		ret = splice(in, NULL, pipefd[1], NULL,
+			     length - done > chunk ? chunk : length - done,
+			     SPLICE_F_MOVE);
+		if (ret <= 0) {
+			done = ret < 0 ? -errno : done;
+			break;
+		}
+
+		while (ret > 0) {
+			n = splice(pipefd[0], NULL, out, NULL, ret,
+				   SPLICE_F_MOVE);
+			if (n <= 0) {
+				done = n < 0 ? -errno : -EIO;
+				goto out;
+			}
+			ret -= n, done += n;
+		}
+	}
+
+out:
+	close(pipefd[0]);
+	close(pipefd[1]);
+
+	return done;
+}
+
+long long copy_fd(int method, int in, int out, long long length,
+		  int chunk, void *buf)
+{
+	switch (method) {
+	case COPY_RW:
+		return copy_rw(in, out, length, chunk, buf);
+	case COPY_CFR:
+		return copy_cfr(in, out, length, chunk);
+	case COPY_SENDFILE:
+		return copy_sendfile(in, out, length, chunk);
+	case COPY_SPLICE:
+		return copy_splice(in, out, length, chunk);
+	default:
+		break;
+	}
+
+	return -EINVAL;
+}
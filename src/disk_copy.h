@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_COPY_H_
+#define _DISK_COPY_H_
+
+#define	COPY_RW			(0)	/* read/write through user buffer */
+#define	COPY_CFR		(1)	/* copy_file_range */
+#define	COPY_SENDFILE		(2)	/* sendfile */
+#define	COPY_SPLICE		(3)	/* splice through a pipe */
+#define	COPY_METHODS		(4)
+
+const char *copy_name(int method);
+
+/*
+ * copy 'length' bytes from 'in' to 'out' from the current offsets,
+ * 'chunk' bytes a call, 'buf' is only used by COPY_RW.
+ * returns copied length or -errno.
+ */
+long long copy_fd(int method, int in, int out, long long length,
+		  int chunk, void *buf);
+
+#endif /* _DISK_COPY_H_ */
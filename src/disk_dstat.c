@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include "disk_dstat.h"
+
+int dstat_path(const char *path, char *file, int size)
+{
+	struct stat st;
+	dev_t dev;
+
+	if (stat(path, &st))
+		return -errno;
+
+	dev = S_ISBLK(st.st_mode) ? st.st_rdev : st.st_dev;
+
+	/* tmpfs, overlay and btrfs have no block device behind */
+	if (!major(dev))
+		return -ENODEV;
+
+	snprintf(file, size, "/sys/dev/block/%u:%u/stat",
+		 major(dev), minor(dev));
+
+	return access(file, R_OK) ? -ENODEV : 0;
+}
+
+int dstat_read(const char *file, struct dstat *ds)
+{
+	FILE *fp;
+	int ret;
+
+	fp = fopen(file, "r");
+	if (!fp)
+		return -errno;
+
+	ret = fscanf(fp, "%llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+		     &ds->rd_ios, &ds->rd_merges, &ds->rd_sectors,
+		     &ds->rd_ticks, &ds->wr_ios, &ds->wr_merges,
+		     &ds->wr_sectors, &ds->wr_ticks, &ds->in_flight,
+		     &ds->io_ticks, &ds->queue_ticks);
+	fclose(fp);
+
+	return ret == 11 ? 0 : -EINVAL;
+}
+
+void dstat_diff(const struct dstat *start, const struct dstat *end,
+		struct dstat *ds)
+{
+	ds->rd_ios = end->rd_ios - start->rd_ios;
+	ds->rd_merges = end->rd_merges - start->rd_merges;
+	ds->rd_sectors = end->rd_sectors - start->rd_sectors;
+	ds->rd_ticks = end->rd_ticks - start->rd_ticks;
+	ds->wr_ios = end->wr_ios - start->wr_ios;
+	ds->wr_merges = end->wr_merges - start->wr_merges;
+	ds->wr_sectors = end->wr_sectors - start->wr_sectors;
+	ds->wr_ticks = end->wr_ticks - start->wr_ticks;
+	ds->in_flight = end->in_flight;
+	ds->io_ticks = end->io_ticks - start->io_ticks;
+	ds->queue_ticks = end->queue_ticks - start->queue_ticks;
+}
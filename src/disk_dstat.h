@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_DSTAT_H_
+#define _DISK_DSTAT_H_
+
+/*
+ * block device counters of /sys/dev/block/<major>:<minor>/stat,
+ * the fields of /proc/diskstats. ticks are msec.
+ */
+struct dstat {
+	unsigned long long rd_ios, rd_merges, rd_sectors, rd_ticks;
+	unsigned long long wr_ios, wr_merges, wr_sectors, wr_ticks;
+	unsigned long long in_flight, io_ticks, queue_ticks;
+};
+
+/*
+ * stat file of the device holding 'path', a block device or a file
+ * on it. returns -ENODEV for a file system without a block device.
+ */
+int dstat_path(const char *path, char *file, int size);
+
+int dstat_read(const char *file, struct dstat *ds);
+
+/* 'ds' = 'end' - 'start', in_flight is the value at the end */
+void dstat_diff(const struct dstat *start, const struct dstat *end,
+		struct dstat *ds);
+
+#endif /* _DISK_DSTAT_H_ */
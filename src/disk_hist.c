@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <string.h>
+
+#include "disk_hist.h"
+
+static int hist_index(unsigned long long value)
+{
+	int shift = 0;
+
+	if (value >= HIST_SUB)
+		shift = (63 - __builtin_clzll(value)) - HIST_SUB_BITS;
+
+	return (shift * HIST_SUB) + (int)(value >> shift);
+}
+
+/* highest value that falls into the bucket */
+static unsigned long long hist_value(int index)
+{
+	int shift = 0;
+
+	if (index >= 2 * HIST_SUB)
+		shift = (index / HIST_SUB) - 1;
+
+	return ((unsigned long long)(index - (shift * HIST_SUB)) << shift) +
+		((1ULL << shift) - 1);
+}
+
+void hist_init(struct hist *h)
+{
+	memset(h, 0, sizeof(*h));
+	h->min = ~0ULL;
+}
+
+void hist_add(struct hist *h, unsigned long long value)
+{
+	h->count[hist_index(value)]++;
+	h->total++;
+	h->sum += value;
+
+	if (value < h->min)
+		h->min = value;
+
+	if (value > h->max)
+		h->max = value;
+}
+
+void hist_merge(struct hist *dst, const struct hist *src)
+{
+	int i;
+
+	if (!src->total)
+		return;
+
+	for (i = 0; i < HIST_BUCKETS; i++)
+		dst->count[i] += src->count[i];
+
+	dst->total += src->total;
+	dst->sum += src->sum;
+
+	if (src->min < dst->min)
+		dst->min = src->min;
+
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+unsigned long long hist_percentile(const struct hist *h, double percent)
+{
+	unsigned long long rank, seen = 0;
+	unsigned long long value;
+	int i;
+
+	if (!h->total)
+		return 0;
+
+	if (percent >= 100.0)
+		return h->max;
+
+	rank = (unsigned long long)((percent / 100.0) * h->total + 0.5);
+	if (rank < 1)
+		rank = 1;
+
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		seen += h->count[i];
+		if (seen >= rank)
+			break;
+	}
+
+	/* bucket bound can not be over the recorded max */
+	value = hist_value(i);
+
+	return value > h->max ? h->max : value;
+}
+
+unsigned long long hist_mean(const struct hist *h)
+{
+	return h->total ? h->sum / h->total : 0;
+}
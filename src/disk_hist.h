@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_HIST_H_
+#define _DISK_HIST_H_
+
+/*
+ * log bucketed latency histogram (HDR style), every power of two range
+ * is split into HIST_SUB linear buckets, so a recorded value keeps
+ * about 3% precision over the whole 64bit range.
+ */
+#define	HIST_SUB_BITS		(5)
+#define	HIST_SUB		(1 << HIST_SUB_BITS)
+#define	HIST_BUCKETS		((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+struct hist {
+	unsigned long long count[HIST_BUCKETS];
+	unsigned long long total;
+	unsigned long long sum;
+	unsigned long long min, max;
+};
+
+void hist_init(struct hist *h);
+void hist_add(struct hist *h, unsigned long long value);
+void hist_merge(struct hist *dst, const struct hist *src);
+
+/* value at 'percent' (0.0 ~ 100.0) of recorded samples */
+unsigned long long hist_percentile(const struct hist *h, double percent);
+unsigned long long hist_mean(const struct hist *h);
+
+#endif /* _DISK_HIST_H_ */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "disk_ival.h"
+
+static unsigned long long ival_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void ival_init(struct ival *iv, unsigned long long period)
+{
+	memset(iv, 0, sizeof(*iv));
+	iv->period = period;
+}
+
+void ival_free(struct ival *iv)
+{
+	free(iv->s);
+	iv->s = NULL;
+	iv->num = iv->size = 0;
+}
+
+static void ival_push(struct ival *iv, unsigned long long end)
+{
+	struct ival_sample *s;
+
+	if (iv->num == iv->size) {
+		s = realloc(iv->s, (iv->size ? iv->size * 2 : 64) *
+			    sizeof(*s));
+		if (!s)
+			return;	/* out of memory, the sample is lost */
+		iv->s = s;
+		iv->size = iv->size ? iv->size * 2 : 64;
+	}
+
+	iv->cur.t = end - iv->start;
+	iv->cur.dt = iv->cur.t - (iv->num ? iv->s[iv->num - 1].t : 0);
+	iv->s[iv->num++] = iv->cur;
+	memset(&iv->cur, 0, sizeof(iv->cur));
+}
+
+void ival_start(struct ival *iv)
+{
+	iv->num = 0;
+	memset(&iv->cur, 0, sizeof(iv->cur));
+	iv->start = ival_now();
+	iv->next = iv->start + iv->period;
+}
+
+void ival_add(struct ival *iv, long long bytes, unsigned long long lat)
+{
+	unsigned long long now;
+
+	if (!iv)
+		return;
+
+	/* a stall over several periods leaves empty intervals */
+	now = ival_now();
+	while (now >= iv->next) {
+		ival_push(iv, iv->next);
+		iv->next += iv->period;
+	}
+
+	iv->cur.bytes += bytes;
+	iv->cur.ios++;
+	if (lat > iv->cur.max)
+		iv->cur.max = lat;
+}
+
+void ival_end(struct ival *iv)
+{
+	if (iv && (iv->cur.ios || !iv->num))
+		ival_push(iv, ival_now());
+}
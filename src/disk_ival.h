@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_IVAL_H_
+#define _DISK_IVAL_H_
+
+/* one interval of a pass */
+struct ival_sample {
+	unsigned long long t;		/* interval end since start, nsec */
+	unsigned long long dt;		/* interval length, nsec */
+	long long bytes;
+	long long ios;
+	unsigned long long max;		/* latency, nsec */
+};
+
+/*
+ * interval time series of one pass, completed requests are summed per
+ * 'period' and kept in memory, so the pass is not slowed by output.
+ */
+struct ival {
+	unsigned long long period;	/* nsec */
+	unsigned long long start, next;
+	struct ival_sample cur;
+	struct ival_sample *s;
+	int num, size;
+};
+
+void ival_init(struct ival *iv, unsigned long long period);
+void ival_free(struct ival *iv);
+
+/* begin the series at the start of the timed pass */
+void ival_start(struct ival *iv);
+
+/* account a completed request, 'iv' may be NULL */
+void ival_add(struct ival *iv, long long bytes, unsigned long long lat);
+
+/* close the last, partial interval */
+void ival_end(struct ival *iv);
+
+#endif /* _DISK_IVAL_H_ */
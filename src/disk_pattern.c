@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <string.h>
+
+#include "disk_pattern.h"
+
+typedef unsigned long long u64;
+
+#define	DEDUP_TAG		(0xDEDEULL << 48)
+
+static u64 splitmix64(u64 x)
+{
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+
+	return x ^ (x >> 31);
+}
+
+/* generate the whole PATTERN_BLOCK at block number 'blk' */
+static void pattern_block(const struct pattern *pat, u64 *buf, u64 blk)
+{
+	u64 id = blk, x;
+	int words = PATTERN_BLOCK / sizeof(u64);
+	int rand_words = words, i;
+
+	if (pat->dedup) {
+		x = splitmix64(pat->seed ^ (blk * 0xD150D150ULL));
+		if ((int)(x % 100) < pat->dedup)
+			id = DEDUP_TAG | ((x >> 32) % PATTERN_DEDUP_POOL);
+	}
+
+	if (pat->compress)
+		rand_words = words - (words * pat->compress) / 100;
+
+	/* xorshift64* stream seeded by the block id */
+	x = splitmix64(pat->seed ^ splitmix64(id));
+	if (!x)
+		x = 1;
+
+	for (i = 0; i < rand_words; i++) {
+		x ^= x >> 12;
+		x ^= x << 25;
+		x ^= x >> 27;
+		buf[i] = x * 0x2545F4914F6CDD1DULL;
+	}
+
+	if (rand_words < words)
+		memset(&buf[rand_words], 0, (words - rand_words) * sizeof(u64));
+}
+
+void pattern_fill(const struct pattern *pat, void *buf, int len,
+		  long long offset)
+{
+	u64 block[PATTERN_BLOCK / sizeof(u64)];
+	char *p = buf;
+
+	while (len > 0) {
+		u64 blk = offset / PATTERN_BLOCK;
+		int pos = offset % PATTERN_BLOCK;
+		int n = PATTERN_BLOCK - pos;
+
+		if (n > len)
+			n = len;
+
+		/* generate in place for a whole aligned block */
+		if (!pos && n == PATTERN_BLOCK &&
+		    !((unsigned long)p & (sizeof(u64) - 1))) {
+			pattern_block(pat, (u64 *)p, blk);
+		} else {
+			pattern_block(pat, block, blk);
+			memcpy(p, (char *)block + pos, n);
+		}
+
+		p += n, offset += n, len -= n;
+	}
+}
+
+int pattern_verify(const struct pattern *pat, const void *buf, int len,
+		   long long offset)
+{
+	u64 block[PATTERN_BLOCK / sizeof(u64)];
+	const char *p = buf;
+	int done = 0;
+
+	while (len > done) {
+		u64 blk = offset / PATTERN_BLOCK;
+		int pos = offset % PATTERN_BLOCK;
+		int n = PATTERN_BLOCK - pos, i;
+
+		if (n > len - done)
+			n = len - done;
+
+		pattern_block(pat, block, blk);
+
+		if (memcmp(p + done, (char *)block + pos, n)) {
+			const unsigned int *w = (const unsigned int *)(p + done);
+			const unsigned int *e = (const unsigned int *)
+						((char *)block + pos);
+
+			for (i = 0; n/4 > i; i++) {
+				if (w[i] != e[i])
+					return (done / 4) + i;
+			}
+		}
+
+		done += n, offset += n;
+	}
+
+	return -1;
+}
+
+unsigned int pattern_word(const struct pattern *pat, long long offset)
+{
+	u64 block[PATTERN_BLOCK / sizeof(u64)];
+
+	pattern_block(pat, block, offset / PATTERN_BLOCK);
+
+	return ((unsigned int *)block)[(offset % PATTERN_BLOCK) / 4];
+}
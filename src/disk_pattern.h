@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_PATTERN_H_
+#define _DISK_PATTERN_H_
+
+#define	PATTERN_SEQ		(0)	/* buf[i] = i, per buffer length */
+#define	PATTERN_GEN		(1)	/* xorshift generated per block */
+
+#define	PATTERN_BLOCK		(4096)
+#define	PATTERN_DEDUP_POOL	(16)
+
+/*
+ * generated data is a function of (seed, file offset), so any range
+ * of the file can be regenerated to verify it. every PATTERN_BLOCK:
+ * - 'dedup' percent of blocks are copies of PATTERN_DEDUP_POOL blocks
+ * - 'compress' percent of a block tail is zero filled
+ */
+struct pattern {
+	int type;
+	int compress;
+	int dedup;
+	unsigned long long seed;
+};
+
+void pattern_fill(const struct pattern *pat, void *buf, int len,
+		  long long offset);
+
+/* returns index of the first mismatched word or -1 */
+int pattern_verify(const struct pattern *pat, const void *buf, int len,
+		   long long offset);
+
+/* expected word at the word aligned 'offset' */
+unsigned int pattern_word(const struct pattern *pat, long long offset);
+
+#endif /* _DISK_PATTERN_H_ */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "disk_rate.h"
+
+#define	NSEC			(1000000000ULL)
+
+static unsigned long long rate_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (unsigned long long)ts.tv_sec * NSEC + ts.tv_nsec;
+}
+
+void rate_init(struct rate *r, unsigned long long bps,
+	       unsigned long long iops)
+{
+	memset(r, 0, sizeof(*r));
+	pthread_mutex_init(&r->lock, NULL);
+	r->bps = bps;
+	r->iops = iops;
+}
+
+void rate_wait(struct rate *r, unsigned int bytes)
+{
+	unsigned long long now, due, cost = 0, c;
+	struct timespec ts;
+
+	if (!r || (!r->bps && !r->iops))
+		return;
+
+	/* the tighter of both limits sets the cost of the request */
+	if (r->bps)
+		cost = (unsigned long long)bytes * NSEC / r->bps;
+
+	if (r->iops) {
+		c = NSEC / r->iops;
+		if (c > cost)
+			cost = c;
+	}
+
+	now = rate_now();
+
+	pthread_mutex_lock(&r->lock);
+	/* an idle bucket fills up to RATE_BURST_NS of tokens, no more */
+	if (r->next + RATE_BURST_NS < now)
+		r->next = now - RATE_BURST_NS;
+	due = r->next;
+	r->next += cost;
+	pthread_mutex_unlock(&r->lock);
+
+	if (due <= now)
+		return;
+
+	ts.tv_sec = due / NSEC;
+	ts.tv_nsec = due % NSEC;
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+	       EINTR)
+		;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_RATE_H_
+#define _DISK_RATE_H_
+
+#include <pthread.h>
+
+/* tokens the bucket holds, absorbs sleep overshoot without a burst */
+#define	RATE_BURST_NS		(10 * 1000 * 1000ULL)
+
+/*
+ * token bucket shared by every worker, limits the bytes and/or the
+ * requests per second. a request reserves its slot on the bucket
+ * clock and sleeps until the slot is due.
+ */
+struct rate {
+	pthread_mutex_t lock;
+	unsigned long long bps;		/* bytes per second, 0 no limit */
+	unsigned long long iops;	/* requests per second, 0 no limit */
+	unsigned long long next;	/* bucket clock, nsec */
+};
+
+void rate_init(struct rate *r, unsigned long long bps,
+	       unsigned long long iops);
+
+/* wait until a request of 'bytes' is allowed */
+void rate_wait(struct rate *r, unsigned int bytes);
+
+#endif /* _DISK_RATE_H_ */
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "disk_result.h"
+
+const char * const result_ops[RESULT_OPS] = { "write", "read", "commit" };
+
+void results_init(struct results *rs)
+{
+	memset(rs, 0, sizeof(*rs));
+	pthread_mutex_init(&rs->lock, NULL);
+}
+
+void results_free(struct results *rs)
+{
+	free(rs->res);
+	rs->res = NULL;
+	rs->num = rs->size = 0;
+}
+
+int results_add(struct results *rs, const struct result *r)
+{
+	struct result *res;
+	int ret = 0;
+
+	pthread_mutex_lock(&rs->lock);
+
+	if (rs->num == rs->size) {
+		res = realloc(rs->res, (rs->size ? rs->size * 2 : 64) *
+			      sizeof(*res));
+		if (!res) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		rs->res = res;
+		rs->size = rs->size ? rs->size * 2 : 64;
+	}
+
+	rs->res[rs->num++] = *r;
+
+out:
+	pthread_mutex_unlock(&rs->lock);
+
+	return ret;
+}
+
+static int result_cmp(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+int results_stat(const struct results *rs, const char *op,
+		 struct result_stat *st)
+{
+	double *v, sum = 0, sq = 0;
+	int i, n = 0;
+
+	memset(st, 0, sizeof(*st));
+
+	v = malloc((rs->num ? rs->num : 1) * sizeof(*v));
+	if (!v)
+		return -ENOMEM;
+
+	for (i = 0; i < rs->num; i++) {
+		if (strcmp(rs->res[i].op, op) || !rs->res[i].usec)
+			continue;
+		v[n++] = rs->res[i].mbs;
+		sum += rs->res[i].mbs;
+	}
+
+	if (!n) {
+		free(v);
+		return -ENOENT;
+	}
+
+	qsort(v, n, sizeof(*v), result_cmp);
+
+	st->num = n;
+	st->min = v[0];
+	st->max = v[n - 1];
+	st->mean = sum / n;
+	st->median = n & 1 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+
+	/* sample deviation, the loops are samples of the device */
+	for (i = 0; i < n; i++)
+		sq += (v[i] - st->mean) * (v[i] - st->mean);
+	st->stddev = n > 1 ? sqrt(sq / (n - 1)) : 0;
+
+	free(v);
+
+	return 0;
+}
+
+static void json_string(FILE *fp, const char *s)
+{
+	if (!s) {
+		fputs("null", fp);
+		return;
+	}
+
+	fputc('"', fp);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', fp);
+		if ((unsigned char)*s < 0x20)
+			fprintf(fp, "\\u%04x", *s);
+		else
+			fputc(*s, fp);
+	}
+	fputc('"', fp);
+}
+
+void results_json(FILE *fp, const char *name, const char *path,
+		  const struct results *rs)
+{
+	struct result_stat st;
+	const struct result *r;
+	int i, n = 0;
+
+	fputs("{\"name\": ", fp);
+	json_string(fp, name);
+	fputs(", \"path\": ", fp);
+	json_string(fp, path);
+	fputs(", \"results\": [", fp);
+
+	for (i = 0; i < rs->num; i++) {
+		r = &rs->res[i];
+		fprintf(fp,
+			"%s\n  {\"op\": \"%s\", \"loop\": %d, \"file\": %d, "
+			"\"file_bytes\": %lld, \"buffer_bytes\": %lld, "
+			"\"bytes\": %lld, \"usec\": %llu, \"mbs\": %.6f, "
+			"\"ios\": %llu, \"lat_p50_ns\": %llu, "
+			"\"lat_p99_ns\": %llu, \"lat_max_ns\": %llu}",
+			i ? "," : "", r->op, r->loop, r->index,
+			r->f_length, r->b_length, r->length, r->usec, r->mbs,
+			r->ios, r->p50, r->p99, r->max);
+	}
+
+	fputs("],\n \"summary\": {", fp);
+
+	for (i = 0; i < RESULT_OPS; i++) {
+		if (results_stat(rs, result_ops[i], &st))
+			continue;
+
+		fprintf(fp,
+			"%s\"%s\": {\"num\": %d, \"min\": %.6f, \"max\": %.6f, "
+			"\"mean\": %.6f, \"stddev\": %.6f, \"median\": %.6f}",
+			n++ ? ", " : "", result_ops[i], st.num, st.min,
+			st.max, st.mean, st.stddev, st.median);
+	}
+
+	fputs("}}", fp);
+}
+
+void results_csv(FILE *fp, const char *name, const struct results *rs,
+		 int header)
+{
+	const struct result *r;
+	int i;
+
+	if (header)
+		fputs("name,op,loop,file,file_bytes,buffer_bytes,bytes,usec,"
+		      "mbs,ios,lat_p50_ns,lat_p99_ns,lat_max_ns\n", fp);
+
+	for (i = 0; i < rs->num; i++) {
+		r = &rs->res[i];
+		fprintf(fp, "%s,%s,%d,%d,%lld,%lld,%lld,%llu,%.6f,%llu,%llu,%llu,%llu\n",
+			name ? name : "", r->op, r->loop, r->index,
+			r->f_length, r->b_length, r->length, r->usec, r->mbs,
+			r->ios, r->p50, r->p99, r->max);
+	}
+}
+
+/* baseline metrics of one op */
+struct result_base {
+	char name[64];
+	char op[8];
+	double mbs;
+	double p50, p99;	/* nsec */
+};
+
+static double result_median(double *v, int n)
+{
+	qsort(v, n, sizeof(*v), result_cmp);
+
+	return n & 1 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+static int result_base(const struct results *rs, const char *name,
+		       const char *op, struct result_base *b)
+{
+	double *v;
+	int i, n = 0, k;
+
+	memset(b, 0, sizeof(*b));
+	snprintf(b->name, sizeof(b->name), "%s", name ? name : "-");
+	snprintf(b->op, sizeof(b->op), "%s", op);
+
+	/* one word in the baseline file */
+	for (i = 0; b->name[i]; i++)
+		if (b->name[i] == ' ' || b->name[i] == '\t')
+			b->name[i] = '_';
+
+	v = malloc((rs->num ? rs->num : 1) * sizeof(*v) * 3);
+	if (!v)
+		return -ENOMEM;
+
+	for (i = 0; i < rs->num; i++) {
+		if (strcmp(rs->res[i].op, op) || !rs->res[i].usec)
+			continue;
+		v[n] = rs->res[i].mbs;
+		v[rs->num + n] = (double)rs->res[i].p50;
+		v[rs->num * 2 + n] = (double)rs->res[i].p99;
+		n++;
+	}
+
+	if (n) {
+		k = rs->num;
+		b->mbs = result_median(v, n);
+		b->p50 = result_median(v + k, n);
+		b->p99 = result_median(v + k * 2, n);
+	}
+	free(v);
+
+	return n ? 0 : -ENOENT;
+}
+
+/* ops of the run in order of their first result */
+static int result_next_op(const struct results *rs, int i)
+{
+	int k;
+
+	for (i++; i < rs->num; i++) {
+		for (k = 0; k < i; k++)
+			if (!strcmp(rs->res[k].op, rs->res[i].op))
+				break;
+		if (k == i)
+			return i;
+	}
+
+	return -1;
+}
+
+void results_save(FILE *fp, const char *name, const struct results *rs)
+{
+	struct result_base b;
+	int i;
+
+	for (i = result_next_op(rs, -1); i >= 0; i = result_next_op(rs, i)) {
+		if (result_base(rs, name, rs->res[i].op, &b))
+			continue;
+
+		fprintf(fp, "%s %s %.6f %.0f %.0f\n",
+			b.name, b.op, b.mbs, b.p50, b.p99);
+	}
+}
+
+static double result_diff(double cur, double base)
+{
+	return base > 0 ? (cur - base) * 100.0 / base : 0;
+}
+
+int results_compare(FILE *fp, const char *name, const struct results *rs,
+		    double tol_mbs, double tol_lat, FILE *out)
+{
+	struct result_base b, c;
+	char line[256];
+	int i, found, fail, num = 0;
+
+	for (i = result_next_op(rs, -1); i >= 0; i = result_next_op(rs, i)) {
+		if (result_base(rs, name, rs->res[i].op, &c))
+			continue;
+
+		rewind(fp);
+		found = 0;
+		while (!found && fgets(line, sizeof(line), fp)) {
+			if (line[0] == '#')
+				continue;
+			if (sscanf(line, "%63s %7s %lf %lf %lf", b.name, b.op,
+				   &b.mbs, &b.p50, &b.p99) == 5 &&
+			    !strcmp(b.name, c.name) && !strcmp(b.op, c.op))
+				found = 1;
+		}
+
+		if (!found) {
+			fprintf(out, "G : %s %s, no baseline\n", c.name, c.op);
+			continue;
+		}
+
+		/* no latency without time info, only a measured one counts */
+		fail = b.mbs > 0 && result_diff(c.mbs, b.mbs) < -tol_mbs;
+		fail |= b.p50 > 0 && c.p50 > 0 &&
+			result_diff(c.p50, b.p50) > tol_lat;
+		fail |= b.p99 > 0 && c.p99 > 0 &&
+			result_diff(c.p99, b.p99) > tol_lat;
+
+		fprintf(out,
+			"G : %s %s, M/S %.3f/%.3f (%+.1f%%), p50 %.1f/%.1f us (%+.1f%%), p99 %.1f/%.1f us (%+.1f%%) %s\n",
+			c.name, c.op, c.mbs, b.mbs, result_diff(c.mbs, b.mbs),
+			c.p50 / 1000, b.p50 / 1000, result_diff(c.p50, b.p50),
+			c.p99 / 1000, b.p99 / 1000, result_diff(c.p99, b.p99),
+			fail ? "REGRESSION" : "ok");
+		num += fail;
+	}
+
+	/* a baseline op the run has no timed result of fails the gate */
+	rewind(fp);
+	while (fgets(line, sizeof(line), fp)) {
+		if (line[0] == '#' ||
+		    sscanf(line, "%63s %7s %lf %lf %lf", b.name, b.op,
+			   &b.mbs, &b.p50, &b.p99) != 5)
+			continue;
+
+		if (result_base(rs, name, b.op, &c) != -ENOENT ||
+		    strcmp(b.name, c.name))
+			continue;
+
+		fprintf(out, "G : %s %s, M/S -/%.3f, no result REGRESSION\n",
+			b.name, b.op, b.mbs);
+		num++;
+	}
+
+	return num;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_RESULT_H_
+#define _DISK_RESULT_H_
+
+#include <stdio.h>
+#include <pthread.h>
+
+/* one test of one file in one loop */
+struct result {
+	char op[8];			/* "write", "read", "commit", .. */
+	int loop, index;
+	long long f_length, b_length;
+	long long length;		/* moved bytes */
+	unsigned long long usec;	/* elapsed, 0 without time info */
+	unsigned long long ios;
+	double mbs;			/* MByte (2^20) per second */
+	unsigned long long p50, p99, max;	/* latency, nsec */
+};
+
+/* results of one run, added by the worker threads */
+struct results {
+	pthread_mutex_t lock;
+	struct result *res;
+	int num, size;
+};
+
+/* ops with a MB/s summary, the 'S :' lines and the JSON summary */
+#define	RESULT_OPS	(3)
+extern const char * const result_ops[RESULT_OPS];
+
+/* MB/s statistics of one op over all loops and files */
+struct result_stat {
+	int num;
+	double min, max, mean, stddev, median;
+};
+
+void results_init(struct results *rs);
+void results_free(struct results *rs);
+int results_add(struct results *rs, const struct result *r);
+
+/* returns 0 and fills 'st' when 'op' has timed results */
+int results_stat(const struct results *rs, const char *op,
+		 struct result_stat *st);
+
+/*
+ * one run as JSON object or CSV rows, 'name' and 'path' identify the
+ * run. the CSV header is written with 'header'.
+ */
+void results_json(FILE *fp, const char *name, const char *path,
+		  const struct results *rs);
+void results_csv(FILE *fp, const char *name, const struct results *rs,
+		 int header);
+
+/*
+ * baseline of a run, per op the median MB/s, p50 and p99 latency of
+ * all files and loops. one '<name> <op> <mbs> <p50 ns> <p99 ns>' line
+ * per op, a NULL 'name' is saved as '-'.
+ */
+void results_save(FILE *fp, const char *name, const struct results *rs);
+
+/*
+ * compare a run with its lines of the baseline 'fp', prints a 'G :'
+ * line per op to 'out'. an op regresses when the MB/s is 'tol_mbs'
+ * percent lower or a latency 'tol_lat' percent higher, or when the
+ * run has no timed result of a baseline op. returns the number of
+ * regressed ops.
+ */
+int results_compare(FILE *fp, const char *name, const struct results *rs,
+		    double tol_mbs, double tol_lat, FILE *out);
+
+#endif /* _DISK_RESULT_H_ */
@@ -19,13 +19,31 @@
 #include <fcntl.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
 #include <sys/vfs.h>
 #include <errno.h>
 #include <sys/time.h>
 #include <sys/times.h>
 #include <time.h>
+#include <pthread.h>
+#include <getopt.h>
+
+#include "disk_uring.h"
+#include "disk_hist.h"
+#include "disk_verify.h"
+#include "disk_pattern.h"
+#include "disk_copy.h"
+#include "disk_rate.h"
+#include "disk_result.h"
+#include "disk_ival.h"
+#include "disk_dstat.h"
+#include "disk_arena.h"
+#include "disk_trace.h"
 
 #define	DISK_SIGNATURE		0xD150D150
+#define	DISK_SIGNATURE_PAT	0xD150D151	/* generated pattern */
 
 #define	KBYTE			(1024)
 #define	MBYTE			(1024 * KBYTE)
@@ -43,10 +61,87 @@
 #define	FILE_PREFIX		"test"
 #define	DISK_PATH		"./"
 #define	DISK_COUNT		(1)
-#define SECTOR_SIZE		KB(1)
+#define SECTOR_SIZE		KB(1)	/* alignment when not detected */
 
 #define	FILE_O_SYNC		(1<<0)
 #define	FILE_O_DIRECT		(1<<1)
+#define	FILE_POOL		(1<<2)	/* flush the file only, no sync() */
+
+#define	VERIFY_RING		(4)
+
+#define	IO_ENGINE_SYNC		(0)
+#define	IO_ENGINE_URING		(1)
+#define	IO_ENGINE_MMAP		(2)
+
+/* page cache state of the file before a read pass */
+#define	FILE_CACHE_SYNC		(0)	/* cold when synced */
+#define	FILE_CACHE_COLD		(1)
+#define	FILE_CACHE_WARM		(2)
+
+#define	TEST_MODE_SEQ		(0)
+#define	TEST_MODE_RAND		(1)
+#define	TEST_MODE_COPY		(2)
+#define	TEST_MODE_MIX		(3)
+#define	TEST_MODE_COMMIT	(4)
+#define	TEST_MODE_META		(5)
+#define	TEST_MODE_REPLAY	(6)
+
+#define	MIX_DEF_READ		(70)	/* read percent of mix mode */
+
+/* commit mode, how an appended record is made durable */
+#define	COMMIT_FSYNC		(0)
+#define	COMMIT_FDATASYNC	(1)
+#define	COMMIT_DSYNC		(2)	/* O_DSYNC write */
+#define	COMMIT_DEF_RECORD	KB(4)
+#define	COMMIT_DEF_SIZE		MB(1)	/* log length, commits * record */
+
+/* meta mode, the phases of a pass run over all files in this order */
+#define	META_CREATE		(0)
+#define	META_STAT		(1)
+#define	META_RENAME		(2)
+#define	META_UNLINK		(3)
+#define	META_OPS		(4)
+#define	META_DEF_FILES		(10000)	/* files per pass */
+#define	META_DEF_FANOUT		(16)	/* directories per pass */
+
+/* long only options */
+#define	OPT_RUNTIME		(0x100)
+#define	OPT_RATE		(0x101)
+#define	OPT_IOPS		(0x102)
+#define	OPT_JOB			(0x103)
+#define	OPT_JSON		(0x104)
+#define	OPT_CSV			(0x105)
+#define	OPT_INTERVAL		(0x106)
+#define	OPT_INTERVAL_LOG	(0x107)
+#define	OPT_POOL		(0x108)
+#define	OPT_CACHE		(0x109)
+#define	OPT_SWEEP		(0x10a)
+#define	OPT_FANOUT		(0x10b)
+#define	OPT_CPU			(0x10c)
+#define	OPT_SCHED		(0x10d)
+#define	OPT_ARENA		(0x10e)
+#define	OPT_TRACE		(0x10f)
+#define	OPT_SAVE		(0x110)
+#define	OPT_COMPARE		(0x111)
+#define	OPT_TOLERANCE		(0x112)
+
+#define	JOB_MAX			(32)	/* sections of a job file */
+
+/* --compare, percent a metric may get worse than the baseline */
+#define	BASE_TOL_MBS		(10)
+#define	BASE_TOL_LAT		(20)
+#define	BASE_EXIT		(2)	/* exit code of a regression */
+
+/* thread roles of --cpu and --sched */
+#define	ROLE_IO			(0)	/* file test workers */
+#define	ROLE_VERIFY		(1)	/* pipelined verify threads */
+#define	ROLE_MAIN		(2)	/* runs the tests and reports */
+#define	ROLE_NUM		(3)
+
+#define	SWEEP_MIN		KB(4)	/* first buffer of a sweep */
+#define	SWEEP_FILES		(8)	/* file lengths of a sweep */
+#define	SWEEP_POINTS		(16)	/* buffer lengths per file length */
+#define	SWEEP_KNEE		(90)	/* percent of the best M/S */
 
 #define	FILE_W_FLAG		(O_RDWR | O_CREAT)
 #define	FILE_R_FLAG		(O_RDONLY)
@@ -54,9 +149,15 @@
 #define	SE(_us)			(_us/1000000)
 #define	US(_us)			(_us%1000000)
 
+/* nsec to usec and its first decimal */
+#define	NS_US(_ns)		((_ns)/1000)
+#define	NS_UF(_ns)		(((_ns)%1000)/100)
+
 #define MBS(_l, _u)		((((u64)_l/(u64)_u)*1000000)/(u64)MBYTE)
 #define	MBU(_l, _u)		((((u64)_l/(u64)_u)*1000000)%(u64)MBYTE)
 
+#define	TV_US(_tv)		((u64)(_tv).tv_sec*1000000 + (_tv).tv_usec)
+
 #define	RUN_TIME_US(s) { \
 	struct timeval tv; \
 	u64 t; \
@@ -85,6 +186,78 @@
 
 typedef unsigned long long  u64;
 
+/* I/O engine parameters of file_write/file_read */
+struct file_param {
+	int engine;		/* IO_ENGINE_xxx */
+	int depth;		/* io_uring requests in flight */
+	bool populate;		/* mmap, MAP_POPULATE */
+	int advise;		/* mmap, madvise hint */
+	bool random;		/* random offset access */
+	bool pipeline;		/* verify in a thread off the read path */
+	struct pattern pat;	/* write data pattern */
+	int align;		/* O_DIRECT buffer and offset alignment */
+	long long base;		/* block device, offset of the test region */
+	struct rate *rate;	/* shared request limiter, NULL no limit */
+	int mix;		/* mix mode, read percent */
+	int cache;		/* FILE_CACHE_xxx of a read pass */
+	int commit;		/* commit mode, COMMIT_xxx */
+	const char *dstat;	/* device counters file, NULL none */
+};
+
+/* I/O statistics of one file pass */
+struct file_stat {
+	long long ios;		/* completed requests */
+	struct hist lat;	/* per request latency, nsec */
+	long long v_length;	/* pipelined verify bytes */
+	u64 v_time;		/* pipelined verify busy time, nsec */
+	u64 v_cpu;		/* pipelined verify thread CPU time, usec */
+	long long length;	/* mixed pass, bytes of one direction */
+	struct ival *ival;	/* interval series of the timed pass */
+	struct dstat dev;	/* device counters of the timed pass */
+	u64 dev_time;		/* between the counter snapshots, usec */
+	bool has_dev;
+};
+
+/*
+ * test file header, 4 words for PATTERN_SEQ and 8 words with the
+ * pattern and seed for generated data.
+ */
+struct file_sign {
+	long long f_length;
+	int b_length;
+	struct pattern pat;
+};
+
+#define	FILE_SIGN_SIZE(s)	((s)->pat.type == PATTERN_SEQ ? 16 : 32)
+
+/* test target, a directory of test files or a raw block device */
+struct disk_geo {
+	bool blkdev;
+	long long size;		/* block device bytes */
+	int lbs, pbs;		/* logical and physical sector */
+	int mem_align;		/* O_DIRECT buffer alignment */
+	int off_align;		/* O_DIRECT offset and length granularity */
+};
+
+static const char * const commit_name[] = {
+	[COMMIT_FSYNC] = "fsync",
+	[COMMIT_FDATASYNC] = "fdatasync",
+	[COMMIT_DSYNC] = "O_DSYNC",
+};
+
+static const char * const meta_name[] = {
+	[META_CREATE] = "create",
+	[META_STAT] = "stat",
+	[META_RENAME] = "rename",
+	[META_UNLINK] = "unlink",
+};
+
+static const char * const io_engine_name[] = {
+	[IO_ENGINE_SYNC] = "sync",
+	[IO_ENGINE_URING] = "io_uring",
+	[IO_ENGINE_MMAP] = "mmap",
+};
+
 static int sched_set_new(pid_t pid, int policy, int priority)
 {
 	struct sched_param param;
@@ -102,7 +275,7 @@ static int sched_set_new(pid_t pid, int policy, int priority)
 		return -EINVAL;
 	}
 
-	if (policy == SCHED_NORMAL) {
+	if (policy == SCHED_NORMAL || policy == SCHED_BATCH) {
 		/*
 		 * #define NICE_TO_PRIO(nice)
 		 *(MAX_RT_PRIO + (nice) + 20), MAX_RT_PRIO 100
@@ -121,7 +294,7 @@ static int sched_set_new(pid_t pid, int policy, int priority)
 		return -EINVAL;
 	}
 
-	if (policy == SCHED_NORMAL) {
+	if (policy == SCHED_NORMAL || policy == SCHED_BATCH) {
 		param.sched_priority = 0;
 		ret = sched_setscheduler(pid, policy, &param);
 		if (ret) {
@@ -143,6 +316,69 @@ static int sched_set_new(pid_t pid, int policy, int priority)
 	return ret;
 }
 
+/* CPU set and schedule of one thread role, process wide */
+struct cpu_role {
+	const char *cpus, *sched;	/* option strings, NULL not set */
+	cpu_set_t set;
+	int policy, priority;
+	int warned;		/* affinity failure reported */
+};
+
+static struct cpu_role cpu_roles[ROLE_NUM];
+
+static const char * const role_name[] = {
+	[ROLE_IO] = "io",
+	[ROLE_VERIFY] = "verify",
+	[ROLE_MAIN] = "main",
+};
+
+/* pin and schedule the calling thread as 'role' */
+static void role_apply(int role)
+{
+	struct cpu_role *r = &cpu_roles[role];
+
+	if (r->cpus && sched_setaffinity(0, sizeof(r->set), &r->set) &&
+	    !__atomic_exchange_n(&r->warned, 1, __ATOMIC_RELAXED))
+		fprintf(stderr, "Fail, %s affinity %s (%d)\n",
+			role_name[role], r->cpus, errno);
+
+	if (r->sched)
+		sched_set_new(0, r->policy, r->priority);
+}
+
+/* affinity and schedule of the calling thread, to undo a role */
+struct role_state {
+	cpu_set_t set;
+	int policy, nice;
+	struct sched_param param;
+};
+
+static void role_save(struct role_state *s)
+{
+	sched_getaffinity(0, sizeof(s->set), &s->set);
+	s->policy = sched_getscheduler(0);
+	sched_getparam(0, &s->param);
+	s->nice = getpriority(PRIO_PROCESS, 0);
+}
+
+static void role_restore(const struct role_state *s)
+{
+	sched_setaffinity(0, sizeof(s->set), &s->set);
+	sched_setscheduler(0, s->policy, &s->param);
+	if (s->policy == SCHED_NORMAL || s->policy == SCHED_BATCH)
+		setpriority(PRIO_PROCESS, 0, s->nice);
+}
+
+/* user and system CPU time of the calling thread, usec */
+static void thread_cpu(u64 *usr, u64 *sys)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_THREAD, &ru);
+	*usr = TV_US(ru.ru_utime);
+	*sys = TV_US(ru.ru_stime);
+}
+
 static long long disk_disk_avail(const char *disk, long long *ptot,
 				 int debug)
 {
@@ -233,12 +469,120 @@ static int disk_obtain_space(const char *disk, int search, long long request)
 	return 0;
 }
 
-static int file_read_sign(const char *file,
-			  long long *pf_length, int *pb_length)
+/*
+ * O_DIRECT alignment of the target, the sector sizes of a block device
+ * or STATX_DIOALIGN of a probe file in the test directory. alignment
+ * the kernel does not report stays at SECTOR_SIZE.
+ */
+static int disk_geometry(const char *disk, struct disk_geo *geo)
+{
+	struct stat st;
+	int fd;
+
+	memset(geo, 0, sizeof(*geo));
+	geo->mem_align = SECTOR_SIZE;
+	geo->off_align = SECTOR_SIZE;
+
+	if (stat(disk, &st) || !S_ISBLK(st.st_mode)) {
+#ifdef STATX_DIOALIGN
+		struct statx stx;
+		char file[256];
+
+		snprintf(file, sizeof(file), "%s/.%s.dio", disk, FILE_PREFIX);
+
+		fd = open(file, O_RDWR | O_CREAT, 0777);
+		if (fd < 0)
+			return 0;
+
+		if (!statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) &&
+		    (stx.stx_mask & STATX_DIOALIGN) &&
+		    stx.stx_dio_offset_align) {
+			geo->mem_align = stx.stx_dio_mem_align;
+			geo->off_align = stx.stx_dio_offset_align;
+		}
+
+		close(fd);
+		remove(file);
+#endif
+		return 0;
+	}
+
+	fd = open(disk, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Fail, open %s (%d)\n", disk, errno);
+		return -errno;
+	}
+
+	if (ioctl(fd, BLKGETSIZE64, &geo->size) ||
+	    ioctl(fd, BLKSSZGET, &geo->lbs)) {
+		fprintf(stderr, "Fail, block device %s (%d)\n", disk, errno);
+		close(fd);
+		return -EINVAL;
+	}
+
+	if (ioctl(fd, BLKPBSZGET, &geo->pbs) || !geo->pbs)
+		geo->pbs = geo->lbs;
+
+	close(fd);
+
+	geo->blkdev = true;
+	geo->mem_align = geo->lbs;
+	geo->off_align = geo->lbs;
+
+	return 0;
+}
+
+/*
+ * evict or load the page cache of one file region. cold writes back
+ * the dirty pages and drops only this file, warm reads it in once so
+ * the pass reads from the page cache.
+ */
+static int file_cache(const char *file, long long base, long long length,
+		      bool warm)
+{
+	long long off = base, end = base + length;
+	char *buf = NULL;
+	long ret = 0;
+	int fd;
+
+	fd = open(file, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Fail, cache open %s (%d)\n", file, errno);
+		return -errno;
+	}
+
+	if (!warm) {
+		fdatasync(fd);
+		ret = posix_fadvise(fd, base, length, POSIX_FADV_DONTNEED);
+		close(fd);
+		return -ret;
+	}
+
+	buf = malloc(MB(1));
+	if (!buf) {
+		close(fd);
+		return -ENOMEM;
+	}
+
+	while (off < end) {
+		ret = pread(fd, buf, end - off > MB(1) ? MB(1) : end - off, off);
+		if (ret <= 0)
+			break;
+		off += ret;
+	}
+
+	free(buf);
+	close(fd);
+
+	return ret < 0 ? -errno : 0;
+}
+
+static int file_read_sign(const char *file, long long base,
+			  struct file_sign *sign)
 {
-	unsigned int data[4] = { 0, };
-	long long f_size;
-	int fd, b_size;
+	unsigned int data[8] = { 0, };
+	struct file_sign sg;
+	int fd;
 	int ret;
 
 	fd = open(file, O_RDWR|O_SYNC, 0777);
@@ -248,35 +592,59 @@ static int file_read_sign(const char *file,
 			return -EINVAL;
 	}
 
-	ret = read(fd, (void *)data, sizeof(data));
+	ret = pread(fd, (void *)data, sizeof(data), base);
 	close(fd);
 
-	if (ret < (int)sizeof(data))
+	if (ret < 16)
 		return -EINVAL;
 
-	if (data[0] != DISK_SIGNATURE) {
+	if (data[0] != DISK_SIGNATURE &&
+	    (data[0] != DISK_SIGNATURE_PAT || ret < (int)sizeof(data))) {
 		fprintf(stderr,
 			"Fail, Unknown signature 0x%08x (0x%08x)\n",
 			data[0], DISK_SIGNATURE);
 		return -EINVAL;
 	}
 
-	b_size = data[1];
-	f_size = (long long)data[2];
+	memset(&sg, 0, sizeof(sg));
+	sg.b_length = data[1];
+	sg.f_length = (long long)data[2] | ((long long)data[3] << 32);
 
-	if (pf_length)
-		*pf_length = f_size;
+	if (data[0] == DISK_SIGNATURE_PAT) {
+		sg.pat.type = PATTERN_GEN;
+		sg.pat.compress = data[4] & 0xFF;
+		sg.pat.dedup = (data[4] >> 8) & 0xFF;
+		sg.pat.seed = (u64)data[6] | ((u64)data[7] << 32);
+	}
 
-	if (pb_length)
-		*pb_length = b_size;
+	if (sign)
+		*sign = sg;
 
 	return 0;
 }
 
-static int file_write_sign(const char *file, long long f_length, int b_length)
+/*
+ * flush for a synced test, sync() takes the dirty data of the whole
+ * system out of the measurement. FILE_POOL keeps it to the test file
+ * so other tenants of the disk are not stalled, 'fd' < 0 is a no-op.
+ */
+static void file_sync(int fd, unsigned long f_flags)
+{
+	if (!(f_flags & FILE_O_SYNC))
+		return;
+
+	if (!(f_flags & FILE_POOL))
+		sync();
+	else if (fd >= 0)
+		fdatasync(fd);
+}
+
+static int file_write_sign(const char *file, long long base,
+			   const struct file_sign *sign,
+			   unsigned long f_flags)
 {
-	unsigned int data[4];
-	int fd, ret;
+	unsigned int data[8] = { 0, };
+	int fd, ret, size = FILE_SIGN_SIZE(sign);
 
 	fd = open(file, O_RDWR|O_SYNC, 0777);
 	if (fd < 0) {
@@ -285,670 +653,4649 @@ static int file_write_sign(const char *file, long long f_length, int b_length)
 	}
 
 	data[0] = DISK_SIGNATURE;
-	data[1] = b_length;
-	data[2] = (f_length) & 0xFFFFFFFF;
-	data[3] = (f_length >> 32) & 0xFFFFFFFF;
+	data[1] = sign->b_length;
+	data[2] = (sign->f_length) & 0xFFFFFFFF;
+	data[3] = (sign->f_length >> 32) & 0xFFFFFFFF;
+
+	if (sign->pat.type == PATTERN_GEN) {
+		data[0] = DISK_SIGNATURE_PAT;
+		data[4] = (sign->pat.compress & 0xFF) |
+			  ((sign->pat.dedup & 0xFF) << 8);
+		data[6] = (sign->pat.seed) & 0xFFFFFFFF;
+		data[7] = (sign->pat.seed >> 32) & 0xFFFFFFFF;
+	}
+
+	ret = pwrite(fd, (void *)&data, size, base);
 
-	ret = write(fd, (void *)&data, sizeof(data));
+	/* O_SYNC is not a data barrier of the file size and the pool */
+	if (f_flags & FILE_POOL)
+		fdatasync(fd);
 	close(fd);
 
-	if (ret < (int)sizeof(data))
+	if (ret < size)
 		return -EINVAL;
 
-	sync();
+	if (!(f_flags & FILE_POOL))
+		sync();
 
 	return 0;
 }
 
-static long long file_write(const char *file, unsigned long f_flags,
-			    long long f_length, int b_length, u64 *time,
-			    int wo, int verify)
+/*
+ * check 'len' bytes read at file 'offset' against the fill pattern of
+ * the file 'sign', the signature words at the head of file are skipped.
+ * returns mismatched word index or -1.
+ */
+static int file_verify(const unsigned int *buf, int len,
+		       long long offset, const struct file_sign *sign)
 {
-	int fd, flags = O_RDWR | O_CREAT;
-	long long w_len, r_len;
-	int *buf;
-	u64 ts = 0, te;
-	int count, i, ret;
+	int b_words = sign->b_length / 4;
+	int words = len / 4, i = 0;
+	unsigned int expect;
+	int run, num;
 
-	if (b_length > BUFFER_MAX_SIZE)
-		b_length = BUFFER_MAX_SIZE;
+	if (offset < FILE_SIGN_SIZE(sign))
+		i = (FILE_SIGN_SIZE(sign) - offset) / 4;
 
-	if (b_length > f_length)
-		b_length = f_length;
+	if (sign->pat.type == PATTERN_GEN) {
+		if (i >= words)
+			return -1;
 
-	ret = posix_memalign((void *)&buf, SECTOR_SIZE, b_length);
-	if (ret) {
-		fprintf(stderr,
-			"Fail: allocate memory buffer %d (%d)\n",
-			b_length, ret);
-		return -ENOMEM;
+		num = pattern_verify(&sign->pat, buf + i, len - (i * 4),
+				     offset + (i * 4));
+		return num < 0 ? -1 : i + num;
 	}
 
-	/* fill buffer */
-	for (i = 0; i < b_length/4; i++)
-		buf[i] = i;
-
-	/* wait for "start of" clock tick */
-	if (f_flags & FILE_O_SYNC)
-		sync();
-
-	flags = FILE_W_FLAG | (f_flags & FILE_O_DIRECT ? O_DIRECT : 0);
+	expect = ((offset / 4) + i) % b_words;
 
-	fd = open(file, flags, 0777);
-	if (fd < 0) {
-		flags = FILE_W_FLAG | (f_flags & FILE_O_SYNC ? O_SYNC : 0);
+	/* the pattern restarts every 'b_words', compare a run at once */
+	while (words > i) {
+		run = b_words - expect;
+		if (run > words - i)
+			run = words - i;
 
-		fd = open(file, flags, 0777);
-		if (fd < 0) {
-			flags = FILE_W_FLAG;
+		num = verify_seq(buf + i, run, expect);
+		if (num >= 0)
+			return i + num;
 
-			fd = open(file, flags, 0777);
-			if (fd < 0) {
-				fprintf(stderr,
-					"Fail, write open %s (%d)\n",
-					file, errno);
-				free(buf);
-				return -EINVAL;
-			}
-		}
+		i += run, expect = 0;
 	}
 
-	count = b_length, w_len = 0;
+	return -1;
+}
 
-	if (time)
-		RUN_TIME_US(ts);
+/* expected word at the word aligned file 'offset' */
+static unsigned int file_expect(const struct file_sign *sign,
+				long long offset)
+{
+	if (sign->pat.type == PATTERN_GEN)
+		return pattern_word(&sign->pat, offset);
 
-	while (count > 0) {
-		ret = write(fd, buf, count);
-		if (ret < 0) {
-			fprintf(stderr,
-				"Fail, wrote %lld (%d)\n", w_len, errno);
-			break;
-		}
+	return (unsigned int)((offset / 4) % (sign->b_length / 4));
+}
 
-		w_len += ret;
-		count = f_length - w_len;
+/* sequential or random offset generator of one file pass */
+struct file_iter {
+	long long base;		/* file offset of request offset 0 */
+	long long f_length;
+	long long offset;	/* sequential position */
+	long long blocks;	/* random, number of aligned blocks */
+	long long ios;		/* issued requests */
+	long long count;	/* random, requests to issue */
+	int b_length;
+	bool random;
+	u64 seed;
+	struct rate *rate;	/* paces every request, NULL no limit */
+	struct ival *ival;	/* interval series, NULL none */
+};
 
-		if (count > b_length)
-			count = b_length;
-	}
+static inline u64 time_ns(void)
+{
+	struct timespec ts;
 
-	/* End */
-	if (f_flags & FILE_O_SYNC)
-		sync();
+	clock_gettime(CLOCK_MONOTONIC, &ts);
 
-	if (time) {
-		END_TIME_US(ts, te);
-		*time = te;
-	}
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
 
-	close(fd);
+static u64 xorshift64(u64 *state)
+{
+	u64 x = *state;
 
-	if (w_len != f_length) {
-		free(buf);
-		return -EINVAL;
-	}
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
 
-	/* set test file info */
-	if (file_write_sign(file, f_length, b_length) < 0)
-		return -EINVAL;
+	return *state = x;
+}
 
-	if (wo)
-		return f_length;
+static void file_iter_init(struct file_iter *it, long long base,
+			   long long f_length, int b_length, bool random,
+			   struct rate *rate)
+{
+	struct timespec ts;
 
-	/* verify open */
-	flags = O_RDONLY | (flags & ~(FILE_W_FLAG));
+	memset(it, 0, sizeof(*it));
+	it->base = base;
+	it->rate = rate;
+	it->f_length = f_length;
+	it->b_length = b_length;
+	it->random = random;
 
-	fd = open(file, flags, 0777);
-	if (fd < 0) {
-		fprintf(stderr,
-			"Fail, write verify open %s (%d)\n", file, errno);
-		free(buf);
-		return -EINVAL;
+	/*
+	 * random access moves 'f_length' bytes with 'b_length' requests
+	 * at 'b_length' aligned offsets inside the file
+	 */
+	if (random) {
+		it->blocks = f_length / b_length;
+		it->count = it->blocks;
 	}
 
-	count = b_length, r_len = 0;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	it->seed = ((u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec) ^
+		   (u64)(unsigned long)it;
+	if (!it->seed)
+		it->seed = DISK_SIGNATURE;
+}
 
-	while (count > 0) {
-		ret = read(fd, buf, count);
-		if (ret < 0) {
-			fprintf(stderr,
-				"Fail, verified %lld (%d)\n", r_len, errno);
-			break;
-		}
+/*
+ * returns length of next request at '*offset', 0 at the end of pass.
+ * with a rate limit it returns when the request is due.
+ */
+static int file_iter_next(struct file_iter *it, long long *offset)
+{
+	long long len;
 
-		if (verify) {
-			for (i = (r_len ? 0 : 4); b_length/4 > i; i++) {
-				if (buf[i] != i) {
-					fprintf(stderr,
-						"Fail, verified 0x%llx, not equal 0x%08x/0x%08x\n",
-						(r_len + (i*4)),
-						(unsigned int)buf[i], i);
-					goto err_write;
-				}
-			}
-		}
+	if (it->random) {
+		if (it->ios >= it->count)
+			return 0;
 
-		r_len += ret;
-		count = f_length - r_len;
+		rate_wait(it->rate, it->b_length);
 
-		if (b_length < count)
-			count = b_length;
+		*offset = (long long)(xorshift64(&it->seed) % it->blocks) *
+			  it->b_length;
+		it->ios++;
+
+		return it->b_length;
 	}
 
-err_write:
-	close(fd);
-	free(buf);
+	if (it->offset >= it->f_length)
+		return 0;
 
-	if (r_len != f_length)
-		return -EINVAL;
+	len = it->f_length - it->offset;
+	if (len > it->b_length)
+		len = it->b_length;
 
-	return r_len;
+	rate_wait(it->rate, len);
+
+	*offset = it->offset;
+	it->offset += len;
+	it->ios++;
+
+	return (int)len;
 }
 
-static long long file_read(const char *file, unsigned long f_flags,
-			   long long f_length, int b_length, u64 *time,
-			   int verify)
+/* total bytes the pass moves */
+static long long file_iter_length(struct file_iter *it)
 {
-	int fd, flags = O_RDONLY;
-	unsigned int *buf;
-	long long r_len, f_len = 0;
-	u64 ts = 0, te;
-	int count, b_len = 0, d_len;
-	long ret;
-	int num;
+	return it->random ? it->count * it->b_length : it->f_length;
+}
 
-	if (file_read_sign(file, &f_len, &b_len) < 0)
-		return -EINVAL;
+/* account a timed request to the histogram and the interval series */
+static inline void file_lat(struct hist *lat, struct file_iter *it,
+			    int len, u64 ts)
+{
+	u64 t;
 
-	if (f_length > f_len)
-		f_length = f_len;
+	if (!lat)
+		return;
 
-	if (b_length > BUFFER_MAX_SIZE)
-		b_length = BUFFER_MAX_SIZE;
+	t = time_ns() - ts;
+	hist_add(lat, t);
+	ival_add(it->ival, len, t);
+}
 
-	if (b_length > f_length)
-		b_length = f_length;
+static void file_verify_fail(const unsigned int *buf, int num,
+			     long long offset, const struct file_sign *sign)
+{
+	fprintf(stderr,
+		"Fail, read 0x%llx, not equal 0x%08x vs 0x%08x ---\n",
+		offset + (num * 4), buf[num],
+		file_expect(sign, offset + (num * 4)));
+}
 
-	/* disk cache flush */
-	if (!access("/proc/sys/vm/drop_caches", W_OK)) {
-		if (f_flags & FILE_O_SYNC)
-			ret = system("echo 3 > /proc/sys/vm/drop_caches > /dev/null");
-	}
+/*
+ * pread/pwrite every request of the iterator, with 'sign' set a write
+ * fills the buffer with generated pattern and a read is verified.
+ */
+static long long file_prw(int fd, bool write, void *buf,
+			  struct file_iter *it, const struct file_sign *sign,
+			  struct hist *lat)
+{
+	long long offset, length = 0;
+	int len, num;
+	ssize_t ret;
+	u64 ts = 0;
 
-	ret = posix_memalign((void *)&buf, SECTOR_SIZE, b_length);
-	if (ret) {
-		fprintf(stderr,
-			"Fail: allocate memory %d (%d)\n", b_length, errno);
-		return -ENOMEM;
-	}
+	while ((len = file_iter_next(it, &offset)) > 0) {
+		if (write && sign && sign->pat.type == PATTERN_GEN)
+			pattern_fill(&sign->pat, buf, len, offset);
 
-	memset(buf, 0, b_length);
+		if (lat)
+			ts = time_ns();
 
-	/* wait for "start of" clock tick */
-	if (f_flags & FILE_O_SYNC)
-		sync();
+		if (write)
+			ret = pwrite(fd, buf, len, it->base + offset);
+		else
+			ret = pread(fd, buf, len, it->base + offset);
 
-	/* verify open */
-	flags = FILE_R_FLAG | (f_flags & FILE_O_DIRECT ? O_DIRECT : 0);
+		file_lat(lat, it, len, ts);
 
-	fd = open(file, flags, 0777);
-	if (fd < 0) {
-		flags = FILE_R_FLAG | (f_flags & FILE_O_SYNC ? O_SYNC : 0);
+		if (ret < len) {
+			fprintf(stderr, "Fail, %s %lld (%d)\n",
+				write ? "wrote" : "read", offset,
+				ret < 0 ? errno : -EIO);
+			break;
+		}
 
-		fd = open(file, flags, 0777);
-		if (fd < 0) {
-			flags = FILE_R_FLAG;
-			fd = open(file, flags, 0777);
-			if (fd < 0) {
-				fprintf(stderr,
-					"Fail, read open %s (%d)\n",
-					file, errno);
-				free(buf);
-				return -EINVAL;
+		if (!write && sign) {
+			num = file_verify(buf, len, offset, sign);
+			if (num >= 0) {
+				file_verify_fail(buf, num, offset, sign);
+				break;
 			}
 		}
+
+		length += len;
 	}
 
-	/* read and verify */
-	count = b_length, r_len = 0, num = 0, b_len /= 4, d_len = b_len - 4;
+	return length;
+}
 
-	if (time)
-		RUN_TIME_US(ts);
+/*
+ * keep 'depth' requests in flight over the file, every slot owns one
+ * of 'bufs' and is requeued with the next offset when it completes.
+ * with 'sign' set a write slot is filled with generated pattern and
+ * a read is verified. request latency is taken from queue to reap.
+ */
+static long long file_uring(struct uring *ring, int fd, bool write,
+			    void **bufs, int depth, struct file_iter *it,
+			    const struct file_sign *sign, struct hist *lat)
+{
+	long long s_off[URING_MAX_DEPTH];
+	int s_len[URING_MAX_DEPTH], s_pos[URING_MAX_DEPTH];
+	u64 s_ts[URING_MAX_DEPTH];
+	long long length = 0;
+	unsigned long long data;
+	int i, res, ret;
+	bool fail = false;
+	bool fill = write && sign && sign->pat.type == PATTERN_GEN;
+
+	for (i = 0; depth > i; i++) {
+		s_len[i] = file_iter_next(it, &s_off[i]), s_pos[i] = 0;
+		if (!s_len[i])
+			break;
 
-	while (count > 0) {
-		ret = read(fd, buf, count);
+		if (fill)
+			pattern_fill(&sign->pat, bufs[i], s_len[i], s_off[i]);
+
+		s_ts[i] = lat ? time_ns() : 0;
+		uring_queue(ring, fd, write, bufs[i], s_len[i],
+			    it->base + s_off[i], i);
+	}
+
+	while (ring->inflight) {
+		ret = uring_wait(ring, 1);
 		if (ret < 0) {
-			fprintf(stderr,
-				"Fail, read %lld (%d)\n", r_len, errno);
-			break;
+			fprintf(stderr, "Fail, io_uring enter (%d)\n", ret);
+			return length;
 		}
 
-		/* verify */
-		if (verify) {
-			for (num = (r_len ? 0 : 4); count/4 > num; num++) {
-				if (!d_len)
-					d_len = b_len;
-
-				if (buf[num] != (unsigned int)(b_len - d_len)) {
-					fprintf(stderr,
-						"Fail, read 0x%llx, not equal 0x%08x vs 0x%08x ---\n",
-						(r_len + (num * 4)),
-						(unsigned int)buf[num],
-						(unsigned int)(b_len - d_len));
-					goto err_read;
+		while (!uring_reap(ring, &data, &res)) {
+			long long pos;
+			char *buf;
+
+			i = (int)data;
+			buf = (char *)bufs[i] + s_pos[i];
+			pos = s_off[i] + s_pos[i];
+
+			if (fail)
+				continue;
+
+			if (res <= 0) {
+				fprintf(stderr, "Fail, %s %lld (%d)\n",
+					write ? "wrote" : "read", pos, -res);
+				fail = true;
+				continue;
+			}
+
+			if (!write && sign) {
+				int num = file_verify((unsigned int *)buf, res,
+						      pos, sign);
+				if (num >= 0) {
+					file_verify_fail((unsigned int *)buf,
+							 num, pos, sign);
+					fail = true;
+					continue;
 				}
-				d_len--;
 			}
+
+			length += res;
+			s_pos[i] += res;
+
+			/* short transfer, queue the rest of the slot */
+			if (s_len[i] > s_pos[i]) {
+				uring_queue(ring, fd, write, buf + res,
+					    s_len[i] - s_pos[i],
+					    it->base + pos + res, i);
+				continue;
+			}
+
+			file_lat(lat, it, s_len[i], s_ts[i]);
+
+			s_len[i] = file_iter_next(it, &s_off[i]), s_pos[i] = 0;
+			if (!s_len[i])
+				continue;
+
+			if (fill)
+				pattern_fill(&sign->pat, bufs[i],
+					     s_len[i], s_off[i]);
+
+			s_ts[i] = lat ? time_ns() : 0;
+			uring_queue(ring, fd, write, bufs[i],
+				    s_len[i], it->base + s_off[i], i);
 		}
+	}
 
-		r_len += ret;
-		count = f_length - r_len;
+	return length;
+}
 
-		if (b_length < count)
-			count = b_length;
+/*
+ * map the file and memcpy every request of the iterator from or to the
+ * mapping, page faults take the place of read/write. with 'sign' set a
+ * write fills the buffer with generated pattern and a read is verified.
+ * written pages are flushed with msync at the end.
+ */
+static long long file_mmap(int fd, bool write, void *buf,
+			   struct file_iter *it, const struct file_sign *sign,
+			   struct hist *lat, const struct file_param *fp)
+{
+	long long offset, length = 0;
+	int flags = MAP_SHARED;
+	int len, num;
+	char *map;
+	u64 t = 0;
+
+	if (fp->populate)
+		flags |= MAP_POPULATE;
+
+	map = mmap(NULL, it->f_length, write ? PROT_READ | PROT_WRITE :
+		   PROT_READ, flags, fd, it->base);
+	if (map == MAP_FAILED) {
+		fprintf(stderr, "Fail, mmap %lld (%d)\n", it->f_length, errno);
+		return 0;
+	}
+
+	if (fp->advise != MADV_NORMAL &&
+	    madvise(map, it->f_length, fp->advise))
+		fprintf(stderr, "Fail, madvise %d (%d)\n", fp->advise, errno);
+
+	while ((len = file_iter_next(it, &offset)) > 0) {
+		if (write && sign && sign->pat.type == PATTERN_GEN)
+			pattern_fill(&sign->pat, buf, len, offset);
+
+		if (lat)
+			t = time_ns();
+
+		if (write)
+			memcpy(map + offset, buf, len);
+		else
+			memcpy(buf, map + offset, len);
+
+		file_lat(lat, it, len, t);
+
+		if (!write && sign) {
+			num = file_verify(buf, len, offset, sign);
+			if (num >= 0) {
+				file_verify_fail(buf, num, offset, sign);
+				break;
+			}
+		}
+
+		length += len;
+	}
+
+	if (write && msync(map, it->f_length, MS_SYNC)) {
+		fprintf(stderr, "Fail, msync (%d)\n", errno);
+		length = 0;
+	}
+
+	munmap(map, it->f_length);
+
+	return length;
+}
+
+/* filled read buffers handed from the reader to the verify thread */
+struct verify_pipe {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	void **bufs;
+	long long off[VERIFY_RING];
+	int len[VERIFY_RING];
+	unsigned int head, tail;	/* filled and verified count */
+	bool done, fail;
+	const struct file_sign *sign;
+	long long length;		/* verified bytes */
+	u64 time;			/* verify busy time, nsec */
+	u64 cpu;			/* verify thread CPU time, usec */
+};
+
+static void *verify_pipe_thread(void *data)
+{
+	struct verify_pipe *vp = data;
+	unsigned int slot;
+	bool fail = false;
+	int num;
+	u64 t, usr, sys;
+
+	role_apply(ROLE_VERIFY);
+
+	pthread_mutex_lock(&vp->lock);
+
+	while (1) {
+		while (vp->tail == vp->head && !vp->done)
+			pthread_cond_wait(&vp->cond, &vp->lock);
+
+		if (vp->tail == vp->head)
+			break;
+
+		slot = vp->tail % VERIFY_RING;
+		pthread_mutex_unlock(&vp->lock);
+
+		if (!fail) {
+			t = time_ns();
+			num = file_verify(vp->bufs[slot], vp->len[slot],
+					  vp->off[slot], vp->sign);
+			vp->time += time_ns() - t;
+
+			if (num >= 0) {
+				file_verify_fail(vp->bufs[slot], num,
+						 vp->off[slot], vp->sign);
+				fail = true;
+			} else {
+				vp->length += vp->len[slot];
+			}
+		}
+
+		pthread_mutex_lock(&vp->lock);
+		vp->fail = fail;
+		vp->tail++;
+		pthread_cond_broadcast(&vp->cond);
+	}
+
+	pthread_mutex_unlock(&vp->lock);
+
+	thread_cpu(&usr, &sys);
+	vp->cpu = usr + sys;
+
+	return NULL;
+}
+
+/*
+ * pread into a ring of VERIFY_RING buffers while the verify thread
+ * checks the filled ones. time waiting for the verify thread is added
+ * to '*stall' so the caller can keep it out of the I/O time.
+ * returns verified length.
+ */
+static long long file_pipe_read(int fd, void **bufs, struct file_iter *it,
+				const struct file_sign *sign, struct hist *lat,
+				struct file_stat *st, u64 *stall)
+{
+	struct verify_pipe vp;
+	long long offset;
+	unsigned int slot;
+	bool fail;
+	int len, ret;
+	u64 t;
+
+	memset(&vp, 0, sizeof(vp));
+	pthread_mutex_init(&vp.lock, NULL);
+	pthread_cond_init(&vp.cond, NULL);
+	vp.bufs = bufs;
+	vp.sign = sign;
+
+	ret = pthread_create(&vp.thread, NULL, verify_pipe_thread, &vp);
+	if (ret) {
+		fprintf(stderr, "Fail, create verify thread (%d)\n", ret);
+		return 0;
+	}
+
+	while ((len = file_iter_next(it, &offset)) > 0) {
+		pthread_mutex_lock(&vp.lock);
+		if (vp.head - vp.tail == VERIFY_RING) {
+			t = time_ns();
+			while (vp.head - vp.tail == VERIFY_RING)
+				pthread_cond_wait(&vp.cond, &vp.lock);
+			*stall += time_ns() - t;
+		}
+		fail = vp.fail;
+		pthread_mutex_unlock(&vp.lock);
+
+		if (fail)
+			break;
+
+		slot = vp.head % VERIFY_RING;
+
+		t = lat ? time_ns() : 0;
+		ret = pread(fd, bufs[slot], len, it->base + offset);
+		file_lat(lat, it, len, t);
+
+		if (ret < len) {
+			fprintf(stderr, "Fail, read %lld (%d)\n",
+				offset, ret < 0 ? errno : -EIO);
+			break;
+		}
+
+		pthread_mutex_lock(&vp.lock);
+		vp.off[slot] = offset, vp.len[slot] = len;
+		vp.head++;
+		pthread_cond_broadcast(&vp.cond);
+		pthread_mutex_unlock(&vp.lock);
+	}
+
+	t = time_ns();
+
+	pthread_mutex_lock(&vp.lock);
+	vp.done = true;
+	pthread_cond_broadcast(&vp.cond);
+	pthread_mutex_unlock(&vp.lock);
+
+	pthread_join(vp.thread, NULL);
+	*stall += time_ns() - t;
+
+	pthread_cond_destroy(&vp.cond);
+	pthread_mutex_destroy(&vp.lock);
+
+	if (st) {
+		st->v_length = vp.length;
+		st->v_time = vp.time;
+		st->v_cpu = vp.cpu;
+	}
+
+	return vp.length;
+}
+
+/*
+ * device counters around a timed pass, 'end' turns the start snapshot
+ * of 'st->dev' into the difference
+ */
+static void file_dev(const struct file_param *fp, struct file_stat *st,
+		     bool end)
+{
+	struct dstat ds;
+
+	if (!st || !fp->dstat)
+		return;
+
+	if (!end) {
+		st->has_dev = !dstat_read(fp->dstat, &st->dev);
+		st->dev_time = time_ns();
+		return;
+	}
+
+	if (st->has_dev && !dstat_read(fp->dstat, &ds)) {
+		st->dev_time = (time_ns() - st->dev_time) / 1000;
+		dstat_diff(&st->dev, &ds, &st->dev);
+	} else {
+		st->has_dev = false;
+	}
+}
+
+/*
+ * open with O_DIRECT as asked, a filesystem refusing direct I/O falls
+ * back to O_SYNC or buffered access and the fallback is reported once,
+ * the numbers are not direct I/O anymore. the used flags are returned
+ * in '*oflags' and the file offset is moved to the test region 'base'.
+ */
+static int file_open(const char *file, int flags, unsigned long f_flags,
+		     long long base, int *oflags)
+{
+	static int warned;
+	int fd;
+
+	if (f_flags & FILE_O_DIRECT) {
+		fd = open(file, flags | O_DIRECT, 0777);
+		if (fd >= 0) {
+			flags |= O_DIRECT;
+			goto out;
+		}
+
+		if (errno != EINVAL)
+			return -errno;
+
+		if (!__atomic_exchange_n(&warned, 1, __ATOMIC_RELAXED))
+			fprintf(stderr,
+				"O_DIRECT not supported on %s, use %s\n",
+				file, f_flags & FILE_O_SYNC ? "O_SYNC" :
+				"buffered I/O");
+
+		if (f_flags & FILE_O_SYNC)
+			flags |= O_SYNC;
+	}
+
+	fd = open(file, flags, 0777);
+	if (fd < 0)
+		return -errno;
+
+out:
+	if (base && lseek(fd, base, SEEK_SET) < 0) {
+		close(fd);
+		return -errno;
+	}
+
+	if (oflags)
+		*oflags = flags;
+
+	return fd;
+}
+
+static long long file_write(const char *file, unsigned long f_flags,
+			    long long f_length, int b_length, u64 *time,
+			    int wo, int verify, const struct file_param *fp,
+			    struct file_stat *st)
+{
+	struct uring ring = { .fd = -1 };
+	void *bufs[URING_MAX_DEPTH] = { NULL, };
+	struct hist *lat = (st && time) ? &st->lat : NULL;
+	struct file_sign sign;
+	struct file_iter it;
+	int fd, flags = O_RDWR | O_CREAT;
+	long long w_len, r_len, length;
+	int *buf;
+	u64 ts = 0, te, t;
+	int count, i, ret, nbufs = 1;
+	size_t filled;
+	bool gen = fp->pat.type == PATTERN_GEN;
+
+	if (b_length > BUFFER_MAX_SIZE)
+		b_length = BUFFER_MAX_SIZE;
+
+	if (b_length > f_length)
+		b_length = f_length;
+
+	/* mapped pages always go through the page cache */
+	if (fp->engine == IO_ENGINE_MMAP)
+		f_flags &= ~FILE_O_DIRECT;
+
+	sign.f_length = f_length;
+	sign.b_length = b_length;
+	sign.pat = fp->pat;
+
+	/* new seed for each file unless given */
+	if (gen && !sign.pat.seed) {
+		u64 seed = time_ns() ^ ((u64)rand() << 20);
+
+		sign.pat.seed = xorshift64(&seed);
+	}
+
+	buf = arena_get(b_length, fp->align, gen ? ARENA_ANY : ARENA_SEQ,
+			&filled);
+	if (!buf) {
+		fprintf(stderr,
+			"Fail: allocate memory buffer %d\n", b_length);
+		return -ENOMEM;
+	}
+
+	/* fill buffer, generated pattern is filled per request */
+	if (gen && !filled)
+		memset(buf, 0, b_length);
+	else if (!gen)
+		for (i = filled/4; i < b_length/4; i++)
+			buf[i] = i;
+
+	/* wait for "start of" clock tick */
+	file_sync(-1, f_flags);
+
+	fd = file_open(file, FILE_W_FLAG, f_flags, fp->base, &flags);
+	if (fd < 0) {
+		fprintf(stderr, "Fail, write open %s (%d)\n", file, -fd);
+		arena_put(buf, ARENA_ANY, 0);
+		return -EINVAL;
+	}
+
+	file_iter_init(&it, fp->base, f_length, b_length, fp->random,
+		       fp->rate);
+	length = file_iter_length(&it);
+	it.ival = lat ? st->ival : NULL;
+
+	/* mapping can not extend the file */
+	if (fp->engine == IO_ENGINE_MMAP) {
+		struct stat st_file;
+
+		if (!fstat(fd, &st_file) && S_ISREG(st_file.st_mode) &&
+		    st_file.st_size < f_length &&
+		    ftruncate(fd, f_length)) {
+			fprintf(stderr, "Fail, truncate %s %lld (%d)\n",
+				file, f_length, errno);
+			close(fd);
+			arena_put(buf, ARENA_ANY, 0);
+			return -EINVAL;
+		}
+	}
+
+	if (fp->engine == IO_ENGINE_URING) {
+		ret = uring_init(&ring, fp->depth);
+		if (ret) {
+			fprintf(stderr, "Fail, io_uring setup (%d)\n", ret);
+			close(fd);
+			arena_put(buf, ARENA_ANY, 0);
+			return ret;
+		}
+
+		/* same pattern for every slot, share the buffer */
+		for (i = 0; i < fp->depth; i++)
+			bufs[i] = buf;
+
+		/* generated pattern differs per offset, buffer per slot */
+		if (gen)
+			nbufs = fp->depth;
+	}
+
+	for (i = 1; i < nbufs; i++) {
+		bufs[i] = arena_get(b_length, fp->align, ARENA_ANY, &filled);
+		if (!bufs[i]) {
+			fprintf(stderr,
+				"Fail: allocate memory buffer %d\n", b_length);
+			nbufs = i;
+			w_len = -1;
+			goto err_bufs;
+		}
+		if (!filled)
+			memset(bufs[i], 0, b_length);
+	}
+
+	if (lat)
+		hist_init(lat);
+
+	count = b_length, w_len = 0;
+
+	if (time) {
+		file_dev(fp, st, false);
+		RUN_TIME_US(ts);
+		if (it.ival)
+			ival_start(it.ival);
+	}
+
+	if (fp->engine == IO_ENGINE_URING) {
+		w_len = file_uring(&ring, fd, true, bufs, fp->depth, &it,
+				   &sign, lat);
+	} else if (fp->engine == IO_ENGINE_MMAP) {
+		w_len = file_mmap(fd, true, buf, &it, &sign, lat, fp);
+	} else if (fp->random) {
+		w_len = file_prw(fd, true, buf, &it, &sign, lat);
+	} else {
+		while (count > 0) {
+			if (gen)
+				pattern_fill(&sign.pat, buf, count, w_len);
+
+			rate_wait(it.rate, count);
+
+			t = lat ? time_ns() : 0;
+			ret = write(fd, buf, count);
+			file_lat(lat, &it, count, t);
+
+			if (ret < 0) {
+				fprintf(stderr,
+					"Fail, wrote %lld (%d)\n",
+					w_len, errno);
+				break;
+			}
+
+			w_len += ret, it.ios++;
+			count = f_length - w_len;
+
+			if (count > b_length)
+				count = b_length;
+		}
 	}
 
 	/* End */
-	if (f_flags & FILE_O_SYNC)
-		sync();
+	file_sync(fd, f_flags);
 
 	if (time) {
 		END_TIME_US(ts, te);
 		*time = te;
+		ival_end(it.ival);
+		file_dev(fp, st, true);
 	}
 
-err_read:
+err_bufs:
+	for (i = 1; i < nbufs; i++)
+		arena_put(bufs[i], ARENA_ANY, 0);
+
+	uring_exit(&ring);
 	close(fd);
-	free(buf);
 
-	if (r_len != f_length)
+	if (w_len != length) {
+		arena_put(buf, ARENA_ANY, 0);
 		return -EINVAL;
+	}
 
-	return r_len;
-}
+	if (st)
+		st->ios = it.ios;
 
-static long long parse_length(int argc, char **argv, char *str,
-			      long long *min, long long *max,
-			      const char *smin, const char *smax,
-			      bool *random)
-{
-	char *s;
-	long long MIN = min ? *min : 0;
-	long long MAX = max ? *max : 0;
-	long long length = 0;
-	bool find = false;
-	int i;
+	/* set test file info */
+	if (file_write_sign(file, fp->base, &sign, f_flags) < 0) {
+		arena_put(buf, ARENA_ANY, 0);
+		return -EINVAL;
+	}
 
-	if (!str)
-		return 0;
+	/* the pattern stays in the buffer for the next write */
+	if (wo) {
+		arena_put(buf, gen ? ARENA_ANY : ARENA_SEQ, b_length);
+		return length;
+	}
 
-	if (strchr(str, 'k') || strchr(str, 'K')) {
-		length = KB(strtoll(str, NULL, 10));
-	} else if (strchr(str, 'm') || strchr(str, 'M')) {
-		length = MB(strtoll(str, NULL, 10));
-	} else if ((s = strchr(str, 'r'))) {
-		for (i = 0; i < argc; i++) {
-			if (s == argv[i])
-				find = true;
+	/* verify open */
+	flags = O_RDONLY | (flags & ~(FILE_W_FLAG));
 
-			if (!find)
-				continue;
+	fd = open(file, flags, 0777);
+	if (fd < 0 || (fp->base && lseek(fd, fp->base, SEEK_SET) < 0)) {
+		fprintf(stderr,
+			"Fail, write verify open %s (%d)\n", file, errno);
+		if (fd >= 0)
+			close(fd);
+		arena_put(buf, ARENA_ANY, 0);
+		return -EINVAL;
+	}
 
-			s = smin ? strstr(argv[i], smin) : NULL;
-			if (s && min) {
-				s = s + strlen(smin);
-				if (strchr(s, 'k') || strchr(s, 'K'))
-					*min = KB(strtoll(s, NULL, 10));
-				else if (strchr(s, 'm') || strchr(s, 'M'))
-					*min = MB(strtoll(s, NULL, 10));
-				else
-					*min = strtoll(s, NULL, 10);
-			}
+	count = b_length, r_len = 0;
 
-			s = smax ? strstr(argv[i], smax) : NULL;
-			if (s && max) {
-				s = s + strlen(smax);
-				if (strchr(s, 'k') || strchr(s, 'K'))
-					*max = KB(strtoll(s, NULL, 10));
-				else if (strchr(s, 'm') || strchr(s, 'M'))
-					*max = MB(strtoll(s, NULL, 10));
-				else
-					*max = strtoll(s, NULL, 10);
+	while (count > 0) {
+		ret = read(fd, buf, count);
+		if (ret < 0) {
+			fprintf(stderr,
+				"Fail, verified %lld (%d)\n", r_len, errno);
+			break;
+		}
+
+		if (verify) {
+			i = file_verify((unsigned int *)buf, ret, r_len, &sign);
+			if (i >= 0) {
+				fprintf(stderr,
+					"Fail, verified 0x%llx, not equal 0x%08x/0x%08x\n",
+					(r_len + (i*4)), (unsigned int)buf[i],
+					file_expect(&sign, r_len + (i*4)));
+				goto err_write;
 			}
 		}
 
-		if (random)
-			*random = true;
+		r_len += ret;
+		count = f_length - r_len;
+
+		if (b_length < count)
+			count = b_length;
+	}
+
+err_write:
+	close(fd);
+	/* the read back put the file and its signature in the buffer */
+	arena_put(buf, ARENA_ANY, 0);
+
+	if (r_len != f_length)
+		return -EINVAL;
+
+	return r_len;
+}
+
+static long long file_read(const char *file, unsigned long f_flags,
+			   long long f_length, int b_length, u64 *time,
+			   int verify, const struct file_param *fp,
+			   struct file_stat *st)
+{
+	struct uring ring = { .fd = -1 };
+	void *bufs[URING_MAX_DEPTH] = { NULL, };
+	struct hist *lat = (st && time) ? &st->lat : NULL;
+	struct file_sign sign, *vs = verify ? &sign : NULL;
+	struct file_iter it;
+	int fd;
+	unsigned int *buf;
+	long long r_len, length;
+	u64 ts = 0, te, t, stall = 0;
+	int count, nbufs = 1;
+	size_t filled;
+	bool pipeline = false;
+	long ret;
+	int num, i;
+
+	if (file_read_sign(file, fp->base, &sign) < 0)
+		return -EINVAL;
+
+	if (f_length > sign.f_length)
+		f_length = sign.f_length;
+
+	if (b_length > BUFFER_MAX_SIZE)
+		b_length = BUFFER_MAX_SIZE;
+
+	if (b_length > f_length)
+		b_length = f_length;
+
+	if (fp->engine == IO_ENGINE_MMAP)
+		f_flags &= ~FILE_O_DIRECT;
+
+	/* page cache of this file only, the other tenants keep theirs */
+	if (fp->cache == FILE_CACHE_WARM) {
+		f_flags &= ~FILE_O_DIRECT;
+		file_cache(file, fp->base, f_length, true);
+	} else if (fp->cache == FILE_CACHE_COLD || (f_flags & FILE_O_SYNC)) {
+		file_cache(file, fp->base, f_length, false);
+	}
+
+	buf = arena_get(b_length, fp->align, ARENA_ANY, &filled);
+	if (!buf) {
+		fprintf(stderr, "Fail: allocate memory %d\n", b_length);
+		return -ENOMEM;
+	}
+
+	/* fault the pages in before the clock runs */
+	if (!filled)
+		memset(buf, 0, b_length);
+
+	/* wait for "start of" clock tick */
+	file_sync(-1, f_flags);
+
+	/* verify open */
+	fd = file_open(file, FILE_R_FLAG, f_flags, fp->base, NULL);
+	if (fd < 0) {
+		fprintf(stderr, "Fail, read open %s (%d)\n", file, -fd);
+		arena_put(buf, ARENA_ANY, 0);
+		return -EINVAL;
+	}
+
+	file_iter_init(&it, fp->base, f_length, b_length, fp->random,
+		       fp->rate);
+	length = file_iter_length(&it);
+	it.ival = lat ? st->ival : NULL;
+
+	if (lat)
+		hist_init(lat);
+
+	if (fp->engine == IO_ENGINE_URING) {
+		ret = uring_init(&ring, fp->depth);
+		if (ret) {
+			fprintf(stderr, "Fail, io_uring setup (%ld)\n", ret);
+			close(fd);
+			arena_put(buf, ARENA_ANY, 0);
+			return ret;
+		}
+
+		/* every request in flight reads into its own buffer */
+		nbufs = fp->depth;
+	} else if (fp->pipeline && verify) {
+		pipeline = true;
+		nbufs = VERIFY_RING;
+	}
+
+	bufs[0] = buf;
+	for (i = 1; i < nbufs; i++) {
+		bufs[i] = arena_get(b_length, fp->align, ARENA_ANY, &filled);
+		if (!bufs[i]) {
+			fprintf(stderr,
+				"Fail: allocate memory %d\n", b_length);
+			r_len = 0;
+			goto err_read;
+		}
+		if (!filled)
+			memset(bufs[i], 0, b_length);
+	}
+
+	/* read and verify */
+	count = b_length, r_len = 0, num = 0;
+
+	if (time) {
+		file_dev(fp, st, false);
+		RUN_TIME_US(ts);
+		if (it.ival)
+			ival_start(it.ival);
+	}
+
+	if (fp->engine == IO_ENGINE_URING) {
+		r_len = file_uring(&ring, fd, false, bufs, fp->depth, &it,
+				   vs, lat);
+		if (r_len != length)
+			goto err_read;
+		count = 0;
+	} else if (fp->engine == IO_ENGINE_MMAP) {
+		r_len = file_mmap(fd, false, buf, &it, vs, lat, fp);
+		if (r_len != length)
+			goto err_read;
+		count = 0;
+	} else if (pipeline) {
+		r_len = file_pipe_read(fd, bufs, &it, vs, lat, st, &stall);
+		if (r_len != length)
+			goto err_read;
+		count = 0;
+	} else if (fp->random) {
+		r_len = file_prw(fd, false, buf, &it, vs, lat);
+		if (r_len != length)
+			goto err_read;
+		count = 0;
+	}
+
+	while (count > 0) {
+		rate_wait(it.rate, count);
+
+		t = lat ? time_ns() : 0;
+		ret = read(fd, buf, count);
+		file_lat(lat, &it, count, t);
+
+		if (ret < 0) {
+			fprintf(stderr,
+				"Fail, read %lld (%d)\n", r_len, errno);
+			break;
+		}
+
+		/* verify */
+		if (verify) {
+			num = file_verify(buf, ret, r_len, vs);
+			if (num >= 0) {
+				file_verify_fail(buf, num, r_len, vs);
+				goto err_read;
+			}
+		}
+
+		r_len += ret, it.ios++;
+		count = f_length - r_len;
+
+		if (b_length < count)
+			count = b_length;
+	}
+
+	/* End */
+	file_sync(fd, f_flags);
+
+	/* pipelined verify, keep waiting for the verify thread out */
+	if (time) {
+		END_TIME_US(ts, te);
+		*time = te - (stall / 1000);
+		ival_end(it.ival);
+		file_dev(fp, st, true);
+	}
+
+	if (st)
+		st->ios = it.ios;
+
+err_read:
+	uring_exit(&ring);
+	for (i = 1; i < nbufs && bufs[i]; i++)
+		arena_put(bufs[i], ARENA_ANY, 0);
+
+	close(fd);
+	arena_put(buf, ARENA_ANY, 0);
+
+	if (r_len != length)
+		return -EINVAL;
+
+	return r_len;
+}
+
+/* write buffer with the file pattern at 'offset' */
+static void file_fill(const struct file_sign *sign, void *buf, int len,
+		      long long offset)
+{
+	unsigned int *p = buf, w, b_words = sign->b_length / 4;
+	int i;
+
+	if (sign->pat.type == PATTERN_GEN) {
+		pattern_fill(&sign->pat, buf, len, offset);
+		return;
+	}
+
+	for (i = 0, w = (offset / 4) % b_words; i < len / 4; i++) {
+		p[i] = w++;
+		if (w == b_words)
+			w = 0;
+	}
+}
+
+/* request slot of a mixed pass */
+struct mix_slot {
+	long long off;
+	int len, pos;
+	bool write;
+	u64 ts;
+};
+
+/* pull the next request and draw its direction by the read share */
+static int mix_next(struct file_iter *it, struct mix_slot *sl, void *buf,
+		    const struct file_sign *sign, int mix)
+{
+	sl->len = file_iter_next(it, &sl->off), sl->pos = 0;
+	if (!sl->len)
+		return 0;
+
+	sl->write = (int)(xorshift64(&it->seed) % 100) >= mix;
+
+	/* a read may have left other data in the buffer */
+	if (sl->write && buf)
+		file_fill(sign, buf, sl->len, sl->off);
+
+	return sl->len;
+}
+
+/* account a completed request of a mixed pass */
+static void mix_done(const struct mix_slot *sl, struct file_stat *rs,
+		     struct file_stat *ws, bool timed)
+{
+	struct file_stat *st = sl->write ? ws : rs;
+
+	st->ios++;
+	st->length += sl->len;
+
+	if (timed) {
+		u64 t = time_ns() - sl->ts;
+
+		hist_add(&st->lat, t);
+		ival_add(st->ival, sl->len, t);
+	}
+}
+
+/* sync engine mixed pass, the requests are drawn in order and taken */
+struct mix_sync {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct file_iter *it;
+	struct mix_slot next;	/* drawn, not taken yet */
+	bool pending, end, fail;
+	const struct file_sign *sign;
+	int fd, mix;
+	bool verify, timed;
+	struct file_stat *rs, *ws;
+};
+
+/* one direction of a sync mixed pass */
+struct mix_side {
+	struct mix_sync *ms;
+	void *buf;
+	bool write;
+};
+
+/*
+ * take the next request of the 'write' direction, waits while the drawn
+ * one belongs to the other side. returns 0 at the end or a failure.
+ */
+static int mix_take(struct mix_sync *ms, bool write, struct mix_slot *sl)
+{
+	int len = 0;
+
+	pthread_mutex_lock(&ms->lock);
+	while (!ms->fail) {
+		if (!ms->pending && !ms->end) {
+			if (mix_next(ms->it, &ms->next, NULL, ms->sign,
+				     ms->mix))
+				ms->pending = true;
+			else
+				ms->end = true;
+			pthread_cond_broadcast(&ms->cond);
+		}
+
+		if (ms->pending && ms->next.write == write) {
+			*sl = ms->next;
+			ms->pending = false;
+			len = sl->len;
+			pthread_cond_broadcast(&ms->cond);
+			break;
+		}
+
+		if (!ms->pending && ms->end)
+			break;
+
+		pthread_cond_wait(&ms->cond, &ms->lock);
+	}
+	pthread_mutex_unlock(&ms->lock);
+
+	return len;
+}
+
+static void *mix_thread(void *data)
+{
+	struct mix_side *side = data;
+	struct mix_sync *ms = side->ms;
+	struct mix_slot sl;
+	int ret, num;
+
+	if (side->write)
+		role_apply(ROLE_IO);
+
+	while (mix_take(ms, side->write, &sl)) {
+		if (sl.write)
+			file_fill(ms->sign, side->buf, sl.len, sl.off);
+
+		sl.ts = ms->timed ? time_ns() : 0;
+
+		if (sl.write)
+			ret = pwrite(ms->fd, side->buf, sl.len,
+				     ms->it->base + sl.off);
+		else
+			ret = pread(ms->fd, side->buf, sl.len,
+				    ms->it->base + sl.off);
+
+		if (ret < sl.len) {
+			fprintf(stderr, "Fail, %s %lld (%d)\n",
+				sl.write ? "wrote" : "read", sl.off,
+				ret < 0 ? errno : -EIO);
+			goto err_side;
+		}
+
+		mix_done(&sl, ms->rs, ms->ws, ms->timed);
+
+		if (!sl.write && ms->verify) {
+			num = file_verify(side->buf, sl.len, sl.off, ms->sign);
+			if (num >= 0) {
+				file_verify_fail(side->buf, num, sl.off,
+						 ms->sign);
+				goto err_side;
+			}
+		}
+	}
+
+	return NULL;
+
+err_side:
+	pthread_mutex_lock(&ms->lock);
+	ms->fail = true;
+	pthread_cond_broadcast(&ms->cond);
+	pthread_mutex_unlock(&ms->lock);
+
+	return NULL;
+}
+
+/*
+ * pread/pwrite mixed pass, the writes run in a second thread so one read
+ * and one write are in flight at once. 'bufs' holds the read and the
+ * write buffer. returns moved length.
+ */
+static long long mix_sync(int fd, void **bufs, struct file_iter *it,
+			  const struct file_sign *sign, bool verify, int mix,
+			  struct file_stat *rs, struct file_stat *ws,
+			  bool timed)
+{
+	struct mix_sync ms = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.cond = PTHREAD_COND_INITIALIZER,
+		.it = it, .sign = sign, .fd = fd, .mix = mix,
+		.verify = verify, .timed = timed, .rs = rs, .ws = ws,
+	};
+	struct mix_side rd = { &ms, bufs[0], false };
+	struct mix_side wr = { &ms, bufs[1], true };
+	pthread_t thread;
+	int ret;
+
+	ret = pthread_create(&thread, NULL, mix_thread, &wr);
+	if (ret) {
+		fprintf(stderr, "Fail, create mix writer (%d)\n", ret);
+		return -ret;
+	}
+
+	mix_thread(&rd);
+	pthread_join(thread, NULL);
+
+	return rs->length + ws->length;
+}
+
+/*
+ * reads and writes of the iterator mixed by 'mix' read percent, writes
+ * put the file pattern back so the reads stay verifiable. with 'ring'
+ * 'depth' requests of both kinds are in flight, else a read and a write
+ * thread issue one pread/pwrite each. the read and write shares are
+ * accounted to 'rs' and 'ws'. returns moved length.
+ */
+static long long file_mix(struct uring *ring, int fd, void **bufs,
+			  int depth, struct file_iter *it,
+			  const struct file_sign *sign, bool verify,
+			  int mix, struct file_stat *rs,
+			  struct file_stat *ws, bool timed)
+{
+	struct mix_slot slots[URING_MAX_DEPTH], *sl;
+	unsigned long long data;
+	long long pos;
+	bool fail = false;
+	int i, res, ret, num;
+	char *buf;
+
+	if (!ring)
+		return mix_sync(fd, bufs, it, sign, verify, mix, rs, ws, timed);
+
+	for (i = 0; depth > i; i++) {
+		sl = &slots[i];
+		if (!mix_next(it, sl, bufs[i], sign, mix))
+			break;
+
+		sl->ts = timed ? time_ns() : 0;
+		uring_queue(ring, fd, sl->write, bufs[i], sl->len,
+			    it->base + sl->off, i);
+	}
+
+	while (ring->inflight) {
+		ret = uring_wait(ring, 1);
+		if (ret < 0) {
+			fprintf(stderr, "Fail, io_uring enter (%d)\n", ret);
+			break;
+		}
+
+		while (!uring_reap(ring, &data, &res)) {
+			i = (int)data;
+			sl = &slots[i];
+			buf = (char *)bufs[i] + sl->pos;
+			pos = sl->off + sl->pos;
+
+			if (fail)
+				continue;
+
+			if (res <= 0) {
+				fprintf(stderr, "Fail, %s %lld (%d)\n",
+					sl->write ? "wrote" : "read", pos, -res);
+				fail = true;
+				continue;
+			}
+
+			if (!sl->write && verify) {
+				num = file_verify((unsigned int *)buf, res,
+						  pos, sign);
+				if (num >= 0) {
+					file_verify_fail((unsigned int *)buf,
+							 num, pos, sign);
+					fail = true;
+					continue;
+				}
+			}
+
+			/* short transfer, queue the rest of the slot */
+			sl->pos += res;
+			if (sl->len > sl->pos) {
+				uring_queue(ring, fd, sl->write, buf + res,
+					    sl->len - sl->pos,
+					    it->base + pos + res, i);
+				continue;
+			}
+
+			mix_done(sl, rs, ws, timed);
+
+			if (!mix_next(it, sl, bufs[i], sign, mix))
+				continue;
+
+			sl->ts = timed ? time_ns() : 0;
+			uring_queue(ring, fd, sl->write, bufs[i], sl->len,
+				    it->base + sl->off, i);
+		}
+	}
+
+	return rs->length + ws->length;
+}
+
+/*
+ * mixed read/write pass over 'f_length' of a file laid out with 'sign',
+ * 'b_length' requests at random offsets. the signature is written back
+ * at the end, a write at the head of the file covers it.
+ */
+static long long file_mixed(const char *file, unsigned long f_flags,
+			    long long f_length, int b_length,
+			    const struct file_sign *sign, u64 *time,
+			    int verify, const struct file_param *fp,
+			    struct file_stat *rs, struct file_stat *ws)
+{
+	struct uring ring = { .fd = -1 }, *pr = NULL;
+	void *bufs[URING_MAX_DEPTH] = { NULL, };
+	int depth = 2, fd, i, ret;	/* sync, a read and a write buffer */
+	struct file_iter it;
+	long long length, len = -EINVAL;
+	u64 ts = 0, te;
+
+	fd = file_open(file, O_RDWR, f_flags, fp->base, NULL);
+	if (fd < 0) {
+		fprintf(stderr, "Fail, mix open %s (%d)\n", file, -fd);
+		return -EINVAL;
+	}
+
+	file_iter_init(&it, fp->base, f_length, b_length, true, fp->rate);
+	length = file_iter_length(&it);
+
+	if (fp->engine == IO_ENGINE_URING) {
+		ret = uring_init(&ring, fp->depth);
+		if (ret) {
+			fprintf(stderr, "Fail, io_uring setup (%d)\n", ret);
+			close(fd);
+			return ret;
+		}
+		pr = &ring, depth = fp->depth;
+	}
+
+	for (i = 0; i < depth; i++) {
+		if (posix_memalign(&bufs[i], fp->align, b_length)) {
+			fprintf(stderr,
+				"Fail: allocate memory %d (%d)\n",
+				b_length, errno);
+			goto err_mix;
+		}
+	}
+
+	hist_init(&rs->lat);
+	hist_init(&ws->lat);
+
+	/* wait for "start of" clock tick */
+	file_sync(fd, f_flags);
+
+	if (time) {
+		RUN_TIME_US(ts);
+		if (rs->ival)
+			ival_start(rs->ival);
+		if (ws->ival)
+			ival_start(ws->ival);
+	}
+
+	len = file_mix(pr, fd, bufs, depth, &it, sign, verify, fp->mix,
+		       rs, ws, time != NULL);
+
+	/* End */
+	file_sync(fd, f_flags);
+
+	if (time) {
+		END_TIME_US(ts, te);
+		*time = te;
+		ival_end(rs->ival);
+		ival_end(ws->ival);
+	}
+
+err_mix:
+	for (i = 0; i < depth; i++)
+		free(bufs[i]);
+
+	uring_exit(&ring);
+	close(fd);
+
+	if (len != length)
+		return -EINVAL;
+
+	if (file_write_sign(file, fp->base, sign, f_flags) < 0)
+		return -EINVAL;
+
+	return len;
+}
+
+/*
+ * database log commits, every 'b_length' record is appended and made
+ * durable before the next one. each request latency is one commit.
+ */
+static long long file_commit(const char *file, unsigned long f_flags,
+			     long long f_length, int b_length, u64 *time,
+			     const struct file_param *fp, struct file_stat *st)
+{
+	struct hist *lat = (st && time) ? &st->lat : NULL;
+	int flags = O_WRONLY | O_CREAT | O_TRUNC | O_APPEND;
+	struct file_iter it;
+	long long offset, length = 0;
+	unsigned int *buf;
+	u64 ts = 0, te, t;
+	int fd, len, i;
+	long ret = 0;
+
+	if (b_length > f_length)
+		b_length = f_length;
+
+	if (fp->commit == COMMIT_DSYNC)
+		flags |= O_DSYNC;
+
+	ret = posix_memalign((void *)&buf, fp->align, b_length);
+	if (ret) {
+		fprintf(stderr,
+			"Fail: allocate memory buffer %d (%ld)\n",
+			b_length, ret);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < b_length/4; i++)
+		buf[i] = i;
+
+	/* the commit is the barrier, no O_SYNC from -s */
+	fd = file_open(file, flags, f_flags & ~FILE_O_SYNC, 0, NULL);
+	if (fd < 0) {
+		fprintf(stderr, "Fail, commit open %s (%d)\n", file, -fd);
+		free(buf);
+		return -EINVAL;
+	}
+
+	file_iter_init(&it, 0, f_length, b_length, false, fp->rate);
+	it.ival = lat ? st->ival : NULL;
+
+	if (lat)
+		hist_init(lat);
+
+	if (time) {
+		RUN_TIME_US(ts);
+		if (it.ival)
+			ival_start(it.ival);
+	}
+
+	while ((len = file_iter_next(&it, &offset)) > 0) {
+		/* record sequence, a torn log shows the last commit */
+		buf[0] = (unsigned int)it.ios;
+
+		t = lat ? time_ns() : 0;
+		ret = write(fd, buf, len);
+		if (ret == len && fp->commit == COMMIT_FSYNC)
+			ret = fsync(fd) ? -1 : len;
+		else if (ret == len && fp->commit == COMMIT_FDATASYNC)
+			ret = fdatasync(fd) ? -1 : len;
+		file_lat(lat, &it, len, t);
+
+		if (ret != len) {
+			fprintf(stderr, "Fail, commit %lld at %lld (%d)\n",
+				it.ios, offset, ret < 0 ? errno : -EIO);
+			break;
+		}
+
+		length += len;
+	}
+
+	if (time) {
+		END_TIME_US(ts, te);
+		*time = te;
+		ival_end(it.ival);
+	}
+
+	if (st)
+		st->ios = it.ios;
+
+	close(fd);
+	free(buf);
+
+	return length == f_length ? length : -EIO;
+}
+
+/*
+ * namespace operations of 'files' small files spread over 'fanout'
+ * directories of 'dir'. every phase runs over all files, a rename stays
+ * in the directory of the file. 'time' and 'st' are per META_xxx.
+ */
+static int file_meta(const char *dir, unsigned long f_flags, int files,
+		     int fanout, int b_length, u64 *time,
+		     const struct file_param *fp, struct file_stat *st)
+{
+	char path[512], dest[512];
+	void *buf = NULL;
+	u64 ts = 0, te, t;
+	int i, op, fd, ret = 0;
+	struct stat sb;
+
+	if (b_length) {
+		buf = malloc(b_length);
+		if (!buf)
+			return -ENOMEM;
+		memset(buf, 0x5a, b_length);
+	}
+
+	for (i = -1; i < fanout; i++) {
+		if (i < 0)
+			snprintf(path, sizeof(path), "%s", dir);
+		else
+			snprintf(path, sizeof(path), "%s/d%d", dir, i);
+
+		if (mkdir(path, 0755) && errno != EEXIST) {
+			fprintf(stderr, "Fail, make dir %s (%d)\n", path, errno);
+			free(buf);
+			return -errno;
+		}
+	}
+
+	for (op = 0; op < META_OPS; op++) {
+		if (time) {
+			hist_init(&st[op].lat);
+			RUN_TIME_US(ts);
+		}
+
+		for (i = 0; i < files && !ret; i++) {
+			snprintf(path, sizeof(path), "%s/d%d/f%d",
+				 dir, i % fanout, i);
+			snprintf(dest, sizeof(dest), "%s/d%d/r%d",
+				 dir, i % fanout, i);
+
+			rate_wait(fp->rate, op == META_CREATE ? b_length : 0);
+
+			t = time ? time_ns() : 0;
+			switch (op) {
+			case META_CREATE:
+				fd = open(path, O_WRONLY | O_CREAT | O_TRUNC,
+					  0644);
+				if (fd < 0) {
+					ret = -errno;
+					break;
+				}
+				if (b_length && write(fd, buf, b_length) !=
+				    b_length)
+					ret = -EIO;
+				close(fd);
+				break;
+			case META_STAT:
+				ret = stat(path, &sb) ? -errno : 0;
+				break;
+			case META_RENAME:
+				ret = rename(path, dest) ? -errno : 0;
+				break;
+			case META_UNLINK:
+				ret = unlink(dest) ? -errno : 0;
+				break;
+			}
+
+			if (time)
+				hist_add(&st[op].lat, time_ns() - t);
+		}
+
+		if (ret) {
+			fprintf(stderr, "Fail, %s %s (%d)\n",
+				meta_name[op], path, -ret);
+			break;
+		}
+
+		/* synced test, the phase ends with its journal commit */
+		if (f_flags & FILE_O_SYNC) {
+			fd = open(dir, O_RDONLY | O_DIRECTORY);
+			if (fd >= 0) {
+				syncfs(fd);
+				close(fd);
+			}
+		}
+
+		if (time) {
+			END_TIME_US(ts, te);
+			time[op] = te;
+		}
+		st[op].ios = files;
+	}
+
+	for (i = 0; i < fanout; i++) {
+		snprintf(path, sizeof(path), "%s/d%d", dir, i);
+		rmdir(path);
+	}
+	rmdir(dir);
+	free(buf);
+
+	return ret;
+}
+
+/* replay pass, index 0 read and 1 write */
+struct replay_stat {
+	struct hist lat[2];	/* replayed request latency */
+	struct hist orig[2];	/* traced latency */
+	struct hist lag;	/* issued behind the trace time */
+	long long ios[2], bytes[2], flush;
+	u64 time;		/* usec */
+};
+
+/*
+ * replay the trace records on the test file or device region. offsets
+ * wrap at 'f_length' and the requests are aligned to the O_DIRECT
+ * granularity, a flush record is a fdatasync().
+ */
+static long long file_replay(const char *file, unsigned long f_flags,
+			     long long f_length, const struct trace *tr,
+			     bool fast, const struct file_param *fp,
+			     struct replay_stat *rs)
+{
+	long long align = fp->align, length = 0, off;
+	long long b_max = (tr->max_length + align - 1) / align * align;
+	const struct trace_rec *r;
+	struct timespec due;
+	unsigned int *buf;
+	u64 start, now, t;
+	int fd, i, w;
+	long len, ret;
+
+	if (b_max > BUFFER_MAX_SIZE)
+		b_max = BUFFER_MAX_SIZE;
+	if (b_max > f_length)
+		b_max = f_length / align * align;
+
+	if (posix_memalign((void *)&buf, align, b_max)) {
+		fprintf(stderr,
+			"Fail: allocate memory buffer %lld\n", b_max);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < b_max/4; i++)
+		buf[i] = i;
+
+	fd = file_open(file, FILE_W_FLAG, f_flags, fp->base, NULL);
+	if (fd < 0) {
+		fprintf(stderr, "Fail, replay open %s (%d)\n", file, -fd);
+		free(buf);
+		return -EINVAL;
+	}
+
+	memset(rs, 0, sizeof(*rs));
+	for (i = 0; i < 2; i++) {
+		hist_init(&rs->lat[i]);
+		hist_init(&rs->orig[i]);
+	}
+	hist_init(&rs->lag);
+
+	start = time_ns();
+
+	for (i = 0; i < tr->num; i++) {
+		r = &tr->recs[i];
+
+		if (!fast) {
+			t = start + r->time;
+			due.tv_sec = t / 1000000000ULL;
+			due.tv_nsec = t % 1000000000ULL;
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+					       &due, NULL) == EINTR)
+				;
+			now = time_ns();
+			hist_add(&rs->lag, now > t ? now - t : 0);
+		}
+
+		if (r->op == 'F') {
+			fdatasync(fd);
+			rs->flush++;
+			continue;
+		}
+
+		len = (r->length + align - 1) / align * align;
+		if (len > b_max)
+			len = b_max;
+		if (!len)
+			len = align;
+
+		off = (long long)(r->offset % (f_length - len + 1));
+		off = off / align * align;
+
+		w = r->op == 'W';
+		rate_wait(fp->rate, len);
+
+		t = time_ns();
+		if (w)
+			ret = pwrite(fd, buf, len, fp->base + off);
+		else
+			ret = pread(fd, buf, len, fp->base + off);
+		hist_add(&rs->lat[w], time_ns() - t);
+
+		if (ret != len) {
+			fprintf(stderr, "Fail, replay %c %lld at %lld (%d)\n",
+				r->op, (long long)len, off,
+				ret < 0 ? errno : -EIO);
+			length = -EIO;
+			break;
+		}
+
+		if (r->latency)
+			hist_add(&rs->orig[w], r->latency);
+
+		rs->ios[w]++;
+		rs->bytes[w] += len;
+		length += len;
+	}
+
+	/* End */
+	file_sync(fd, f_flags);
+	rs->time = (time_ns() - start) / 1000;
+
+	close(fd);
+	free(buf);
+
+	return length;
+}
+
+static long long parse_length(int argc, char **argv, char *str,
+			      long long *min, long long *max,
+			      const char *smin, const char *smax,
+			      bool *random, int align)
+{
+	char *s;
+	long long MIN = min ? *min : 0;
+	long long MAX = max ? *max : 0;
+	long long length = 0;
+	bool find = false;
+	int i;
+
+	if (!str)
+		return 0;
+
+	if (strchr(str, 'k') || strchr(str, 'K')) {
+		length = KB(strtoll(str, NULL, 10));
+	} else if (strchr(str, 'm') || strchr(str, 'M')) {
+		length = MB(strtoll(str, NULL, 10));
+	} else if ((s = strchr(str, 'r'))) {
+		for (i = 0; i < argc; i++) {
+			if (s == argv[i])
+				find = true;
+
+			if (!find)
+				continue;
+
+			s = smin ? strstr(argv[i], smin) : NULL;
+			if (s && min) {
+				s = s + strlen(smin);
+				if (strchr(s, 'k') || strchr(s, 'K'))
+					*min = KB(strtoll(s, NULL, 10));
+				else if (strchr(s, 'm') || strchr(s, 'M'))
+					*min = MB(strtoll(s, NULL, 10));
+				else
+					*min = strtoll(s, NULL, 10);
+			}
+
+			s = smax ? strstr(argv[i], smax) : NULL;
+			if (s && max) {
+				s = s + strlen(smax);
+				if (strchr(s, 'k') || strchr(s, 'K'))
+					*max = KB(strtoll(s, NULL, 10));
+				else if (strchr(s, 'm') || strchr(s, 'M'))
+					*max = MB(strtoll(s, NULL, 10));
+				else
+					*max = strtoll(s, NULL, 10);
+			}
+		}
+
+		if (random)
+			*random = true;
+
+		if (min && MIN > *min)
+			*min = MIN;
+
+		if (min && MAX < *min)
+			*min = MAX;
+
+		if (max && MIN > *max)
+			*max = MIN;
+
+		if (max && MAX < *max)
+			*max = MAX;
+	} else {
+		/* align with sector size */
+		length = (strtoll(str, NULL, 10) + align - 1) /
+			  align * align;
+	}
+
+	return length;
+}
+
+/* serialize free space reclaim between worker threads */
+static pthread_mutex_t space_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* check disk free, no 'disk' for a block device region */
+static int test_space(const char *disk, int counts, long long f_length)
+{
+	long long disk_avail;
+
+	pthread_mutex_lock(&space_lock);
+	disk_avail = disk ? disk_disk_avail(disk, NULL, 0) : f_length;
+	if (f_length > disk_avail) {
+		int ret = disk_obtain_space(disk, counts, f_length);
+
+		if (ret < 0) {
+			fprintf(stderr,
+				"No space left, free %lld, req %lld\n",
+				disk_disk_avail(disk, NULL, 0), f_length);
+			pthread_mutex_unlock(&space_lock);
+			return -ENOMEM;
+		}
+	}
+	pthread_mutex_unlock(&space_lock);
+
+	return 0;
+}
+
+/*
+ * overwriting blocks in place needs a file laid out with the same
+ * pattern, the same buffer length for PATTERN_SEQ and the same seed
+ * for generated data, so the file stays valid to verify. the file is
+ * written again otherwise, its signature is returned in 'sign'.
+ */
+static int test_layout(const char *file, ulong f_flags,
+		       long long f_length, int b_length, bool verify,
+		       const struct file_param *fp, struct file_sign *sign)
+{
+	struct file_param seq = *fp;
+	long long size;
+
+	seq.random = false;
+	seq.rate = NULL;	/* layout is not part of the load */
+
+	if (file_read_sign(file, fp->base, sign) < 0 ||
+	    sign->pat.type != fp->pat.type ||
+	    sign->pat.compress != fp->pat.compress ||
+	    sign->pat.dedup != fp->pat.dedup ||
+	    (fp->pat.seed && sign->pat.seed != fp->pat.seed) ||
+	    (fp->pat.type == PATTERN_SEQ && sign->b_length != b_length) ||
+	    sign->f_length < f_length) {
+		size = file_write(file, f_flags, f_length, b_length,
+				  NULL, 1, verify, &seq, NULL);
+		if (size < 0) {
+			fprintf(stderr, "Fail layout file, length %lld\n",
+				size);
+			return (int)size;
+		}
+
+		if (file_read_sign(file, fp->base, sign) < 0)
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int test_write(const char *disk, const char *file,
+		      ulong f_flags, long long f_length, int b_length,
+		      long long *length, int counts, bool verify, u64 *time,
+		      const struct file_param *fp, struct file_stat *st)
+{
+	struct file_param rnd = *fp;
+	struct file_sign sign;
+	long long size;
+	int ret;
+
+	ret = test_space(disk, counts, f_length);
+	if (ret < 0)
+		return ret;
+
+	/* random write overwrites blocks of a laid out file */
+	if (fp->random) {
+		if (b_length > BUFFER_MAX_SIZE)
+			b_length = BUFFER_MAX_SIZE;
+
+		if (b_length > f_length)
+			b_length = f_length;
+
+		ret = test_layout(file, f_flags, f_length, b_length, verify,
+				  fp, &sign);
+		if (ret < 0)
+			return ret;
+
+		rnd.pat.seed = sign.pat.seed;
+	}
+
+	size = file_write(file, f_flags, f_length, b_length,
+			    time, 1, verify, &rnd, st);
+	if (size < 0) {
+		fprintf(stderr, "Fail write file, length %lld\n", size);
+		return (int)size;
+	}
+
+	if (length)
+		*length = size;
+
+	return 0;
+}
+
+/* write the test file when it is not a signed one */
+static int test_prepare(const char *disk, const char *file,
+			ulong f_flags, long long f_length, int b_length,
+			int counts, bool verify, const struct file_param *fp)
+{
+	struct file_param seq = *fp;
+	long long size;
+
+	/*
+	 * check exist file
+	 */
+	if (file_read_sign(file, fp->base, NULL) < 0) {
+		int ret = test_space(disk, counts, f_length);
+
+		if (ret < 0)
+			return ret;
+
+		seq.random = false;
+		seq.rate = NULL;	/* layout is not part of the load */
+
+		size = file_write(file, f_flags, f_length, b_length,
+				    NULL, 0, verify, &seq, NULL);
+		if (size < 0) {
+			fprintf(stderr,
+				"Fail write file to read, length %lld\n", size);
+			return (int)size;
+		}
+	}
+
+	return 0;
+}
+
+static int test_read(const char *disk, const char *file,
+		     ulong f_flags, long long f_length, int b_length,
+		     long long *length, int counts, bool verify, u64 *time,
+		     const struct file_param *fp, struct file_stat *st)
+{
+	long long size;
+	int ret;
+
+	ret = test_prepare(disk, file, f_flags, f_length, b_length,
+			   counts, verify, fp);
+	if (ret < 0)
+		return ret;
+
+	/*
+	 * read test
+	 */
+	size = file_read(file, f_flags, f_length, b_length, time,
+			 verify, fp, st);
+	if (size < 0) {
+		fprintf(stderr, "Fail read length %lld\n", size);
+		return (int)size;
+	}
+
+	if (length)
+		*length = size;
+
+	return 0;
+}
+
+/*
+ * mixed test, reads and writes of 'b_length' at random offsets of a
+ * laid out file at the fp->mix read share, accounted to 'rs' and 'ws'.
+ */
+static int test_mix(const char *disk, const char *file,
+		    ulong f_flags, long long f_length, int b_length,
+		    int counts, bool verify, u64 *time,
+		    const struct file_param *fp,
+		    struct file_stat *rs, struct file_stat *ws)
+{
+	struct file_sign sign;
+	long long size;
+	int ret;
+
+	if (b_length > BUFFER_MAX_SIZE)
+		b_length = BUFFER_MAX_SIZE;
+
+	if (b_length > f_length)
+		b_length = f_length;
+
+	ret = test_space(disk, counts, f_length);
+	if (ret < 0)
+		return ret;
+
+	ret = test_layout(file, f_flags, f_length, b_length, verify, fp,
+			  &sign);
+	if (ret < 0)
+		return ret;
+
+	size = file_mixed(file, f_flags, f_length, b_length, &sign, time,
+			  verify, fp, rs, ws);
+	if (size < 0) {
+		fprintf(stderr, "Fail mix length %lld\n", size);
+		return (int)size;
+	}
+
+	return 0;
+}
+
+/* commit mode, a log of -b records over -f, one commit per record */
+static int test_commit(const char *disk, const char *file,
+		       ulong f_flags, long long f_length, int b_length,
+		       long long *length, int counts, u64 *time,
+		       const struct file_param *fp, struct file_stat *st)
+{
+	long long size;
+	int ret;
+
+	ret = test_space(disk, counts, f_length);
+	if (ret < 0)
+		return ret;
+
+	size = file_commit(file, f_flags, f_length, b_length, time, fp, st);
+	if (size < 0) {
+		fprintf(stderr, "Fail commit length %lld\n", size);
+		return (int)size;
+	}
+
+	if (length)
+		*length = size;
+
+	return 0;
+}
+
+/* replay mode, the trace over the test file, laid out when short */
+static int test_replay(const char *disk, const char *file,
+		       ulong f_flags, long long f_length, int b_length,
+		       int counts, const struct trace *tr, bool fast,
+		       const struct file_param *fp, struct replay_stat *rs)
+{
+	struct file_param seq = *fp;
+	long long size;
+	struct stat sb;
+	int ret;
+
+	/* lay out a short file, a device region is replayed as it is */
+	if (disk && (stat(file, &sb) || sb.st_size < f_length)) {
+		ret = test_space(disk, counts, f_length);
+		if (ret < 0)
+			return ret;
+
+		seq.random = false;
+		seq.rate = NULL;
+
+		size = file_write(file, f_flags, f_length, b_length,
+				  NULL, 1, 0, &seq, NULL);
+		if (size < 0) {
+			fprintf(stderr,
+				"Fail write file to replay, length %lld\n", size);
+			return (int)size;
+		}
+	}
+
+	size = file_replay(file, f_flags, f_length, tr, fast, fp, rs);
+	if (size < 0) {
+		fprintf(stderr, "Fail replay length %lld\n", size);
+		return (int)size;
+	}
+
+	return 0;
+}
+
+/*
+ * copy the signed test file to '<file>.copy' with every COPY_xxx method,
+ * each copy is verified with file_read and removed again.
+ * result lines are formatted to 'out'.
+ */
+static int test_copy(const char *disk, const char *file,
+		     ulong f_flags, long long f_length, int b_length,
+		     int counts, bool verify, const struct file_param *fp,
+		     char *out, int size, int *pn)
+{
+	struct file_param rd = {
+		.engine = IO_ENGINE_SYNC, .depth = 1, .align = fp->align,
+	};
+	struct file_sign sign;
+	struct rusage r0, r1;
+	char dest[512];
+	long long length, len;
+	int method, in, dst, ret;
+	int n = *pn;
+	void *buf;
+	u64 ts = 0, te, usr, sys;
+
+	ret = test_prepare(disk, file, f_flags, f_length, b_length,
+			   counts, verify, fp);
+	if (ret < 0)
+		return ret;
+
+	if (file_read_sign(file, fp->base, &sign) < 0)
+		return -EINVAL;
+
+	length = sign.f_length;
+	if (b_length > BUFFER_MAX_SIZE)
+		b_length = BUFFER_MAX_SIZE;
+
+	pthread_mutex_lock(&space_lock);
+	if (length > disk_disk_avail(disk, NULL, 0) &&
+	    disk_obtain_space(disk, counts, length) < 0) {
+		fprintf(stderr, "No space left, free %lld, req %lld\n",
+			disk_disk_avail(disk, NULL, 0), length);
+		pthread_mutex_unlock(&space_lock);
+		return -ENOMEM;
+	}
+	pthread_mutex_unlock(&space_lock);
+
+	if (posix_memalign(&buf, fp->align, b_length)) {
+		fprintf(stderr,
+			"Fail: allocate memory %d (%d)\n", b_length, errno);
+		return -ENOMEM;
+	}
+
+	snprintf(dest, sizeof(dest), "%s.copy", file);
+
+	for (method = 0; method < COPY_METHODS; method++) {
+		in = open(file, O_RDONLY);
+		dst = open(dest, O_WRONLY | O_CREAT | O_TRUNC, 0777);
+		if (in < 0 || dst < 0) {
+			fprintf(stderr, "Fail, copy open %s (%d)\n",
+				in < 0 ? file : dest, errno);
+			if (in >= 0)
+				close(in);
+			ret = -EINVAL;
+			break;
+		}
+
+		/* every method starts with the source out of page cache */
+		if (f_flags & FILE_O_SYNC)
+			posix_fadvise(in, 0, 0, POSIX_FADV_DONTNEED);
+
+		getrusage(RUSAGE_THREAD, &r0);
+		RUN_TIME_US(ts);
+
+		len = copy_fd(method, in, dst, length, b_length, buf);
+
+		if (f_flags & FILE_O_SYNC)
+			fsync(dst);
+
+		END_TIME_US(ts, te);
+		getrusage(RUSAGE_THREAD, &r1);
+
+		close(in);
+		close(dst);
+
+		if (len == -ENOSYS || len == -EXDEV ||
+		    len == -EOPNOTSUPP || len == -EINVAL) {
+			n += snprintf(out + n, size - n,
+				"C : %-16s not supported (%lld)\n",
+				copy_name(method), len);
+			remove(dest);
+			continue;
+		}
+
+		if (len != length) {
+			fprintf(stderr, "Fail, %s copied %lld/%lld\n",
+				copy_name(method), len, length);
+			remove(dest);
+			ret = -EIO;
+			break;
+		}
+
+		if (verify && file_read(dest, 0, length, b_length, NULL,
+					1, &rd, NULL) < 0) {
+			fprintf(stderr, "Fail, %s verify %s\n",
+				copy_name(method), dest);
+			remove(dest);
+			ret = -EIO;
+			break;
+		}
+		remove(dest);
+
+		usr = TV_US(r1.ru_utime) - TV_US(r0.ru_utime);
+		sys = TV_US(r1.ru_stime) - TV_US(r0.ru_stime);
+
+		n += snprintf(out + n, size - n,
+			"C : %-16s %3lld.%06lld, %lld/%d (%3lld.%6lld M/S) cpu usr %lld.%06lld sys %lld.%06lld\n",
+			copy_name(method), SE(te), US(te), length, b_length,
+			te ? MBS(length, te) : 0, te ? MBU(length, te) : 0,
+			SE(usr), US(usr), SE(sys), US(sys));
+	}
+
+	free(buf);
+	*pn = n;
+
+	return ret;
+}
+
+static void print_usage(void)
+{
+	printf("\n");
+	printf("usage: options\n");
+	printf("-p directory path or block device (e.g. /dev/mmcblk0p3),\n");
+	printf("   default current path, a device is overwritten per file region\n");
+	printf("-r read  option, default read\n");
+	printf("-w write option, default read\n");
+	printf("-b rw buffer len, default %dKbyte (k=Kbyte, m=Mbyte, r=random)\n",
+		BUFFER_DEF_SIZE/MBYTE);
+	printf("   bmin=n, random min, default and limit min  %dbyte\n",
+		BUFFER_MIN_SIZE);
+	printf("   bmax=n, random max, default and limit max %dMbyte\n",
+		BUFFER_MAX_SIZE/MBYTE);
+	printf("-f rw file len, default %dMbyte (k=Kbyte, m=Mbyte, r=random)\n",
+		FILE_DEF_SIZE/MBYTE);
+	printf("   fmin=n, random min, default and limit min %dMbyte\n",
+		FILE_MIN_SIZE/MBYTE);
+	printf("   fmax=n, random max, default and limit max %dMbyte\n",
+		FILE_MAX_SIZE/MBYTE);
+	printf("-c test count, default %d\n", DISK_COUNT);
+	printf("-l loop\n");
+	printf("-j worker threads, run test files in parallel, default 1\n");
+	printf("-e io engine, sync, uring or mmap, default sync\n");
+	printf("   mmap,populate maps with MAP_POPULATE\n");
+	printf("   mmap,seq|rand|willneed gives madvise hint\n");
+	printf("-q io_uring queue depth, default %d, max %d\n",
+		URING_DEF_DEPTH, URING_MAX_DEPTH);
+	printf("-P pipelined verify, a thread verifies a ring of %d read buffers\n",
+		VERIFY_RING);
+	printf("-d data pattern, default seq (buf[i] = i)\n");
+	printf("   rand, incompressible xorshift data per %d byte block\n",
+		PATTERN_BLOCK);
+	printf("   comp=n, rand with n%% of a block zero filled\n");
+	printf("   dedup=n, rand with n%% of blocks from %d duplicated blocks\n",
+		PATTERN_DEDUP_POOL);
+	printf("   seed=n, rand seed, default new seed per file\n");
+	printf("   e.g. -d comp=50,dedup=20\n");
+	printf("-m test mode, default seq\n");
+	printf("   seq, sequential read/write\n");
+	printf("   rand, read/write at buffer len aligned random offsets\n");
+	printf("   copy, copy test file with read/write, copy_file_range,\n");
+	printf("         sendfile and splice (buffer len per call)\n");
+	printf("   mix=n, reads and writes at random offsets at once, n%% reads,\n");
+	printf("         default %d, sync (a read and a write thread) or\n",
+		MIX_DEF_READ);
+	printf("         uring engine (-q in flight)\n");
+	printf("   commit[=fsync|fdatasync|dsync], append -b records (default %dKbyte)\n",
+		COMMIT_DEF_RECORD/KBYTE);
+	printf("         up to -f (default %dMbyte), each made durable before\n",
+		COMMIT_DEF_SIZE/MBYTE);
+	printf("         the next, default fdatasync, dsync writes with O_DSYNC\n");
+	printf("   meta[=n], create, stat, rename and unlink n files per count\n");
+	printf("         (default %d) over --fanout dirs, files of -b byte,\n",
+		META_DEF_FILES);
+	printf("         default empty, -j runs counts in parallel\n");
+	printf("   replay[=fast], replay the --trace records at the trace time\n");
+	printf("         or as fast as possible, offsets wrap at -f\n");
+	printf("-s no sync access, default sync\n");
+	printf("-t no time info,\n");
+	printf("-n set priority, FIFO 99\n");
+	printf("-v skip verify\n");
+	printf("--runtime n, run test files until n sec (s, m=min, h=hour),\n");
+	printf("   the running files finish, -l still bounds the loops\n");
+	printf("--rate n, limit bytes per second of all workers (k, m, g)\n");
+	printf("--iops n, limit requests per second of all workers\n");
+	printf("--json file, write every file test and the MB/s summary as JSON\n");
+	printf("--csv file, write every file test as CSV\n");
+	printf("--interval n, bytes, IOPS and max latency every n msec of a pass\n");
+	printf("--interval-log file, write the intervals as CSV, not to stdout\n");
+	printf("--pool, allocate the test files once and overwrite them in place,\n");
+	printf("   fails up front without space, syncs the test file only\n");
+	printf("--cache cold|warm, page cache of the file before a read pass,\n");
+	printf("   cold drops it, warm reads it in and reads buffered,\n");
+	printf("   default cold when synced\n");
+	printf("--sweep[=n,n,..], buffer len from %dKbyte to %dMbyte in powers\n",
+		SWEEP_MIN/KBYTE, BUFFER_MAX_SIZE/MBYTE);
+	printf("   of two for the file lens n (k, m, g), default -f, one file,\n");
+	printf("   prints M/S and p99 per buffer and the knee of the curve\n");
+	printf("--fanout n, meta mode directories per count, default %d\n",
+		META_DEF_FANOUT);
+	printf("--cpu role=n,n-m, pin the threads of a role to the cpus\n");
+	printf("--sched role=other|batch|fifo|rr[:n], policy and priority\n");
+	printf("   (nice for other/batch) of a role, default fifo/rr 99\n");
+	printf("   roles: io workers, verify (-P) threads, main reporter,\n");
+	printf("   with -j 1 the worker runs in the main thread as io\n");
+	printf("--trace file, replay mode trace, text lines of\n");
+	printf("   '<sec> <R|W|F> <offset> <length> [<latency us>]' or binary\n");
+	printf("   (see disk_trace.h for the blkparse conversion)\n");
+	printf("--arena[=thp|huge], keep the I/O buffers and the written\n");
+	printf("   pattern for the next file, thp backs them with transparent\n");
+	printf("   huge pages, huge with hugetlb pages (THP when none)\n");
+	printf("--save file, write M/S, p50 and p99 of each op as baseline\n");
+	printf("--compare file, check the run against a --save baseline,\n");
+	printf("   exits %d when an op regresses, runs before --save\n",
+		BASE_EXIT);
+	printf("--tolerance n[,m], percent M/S may drop (default %d) and\n",
+		BASE_TOL_MBS);
+	printf("   p50/p99 may rise (default %d) before a regression\n",
+		BASE_TOL_LAT);
+	printf("--job file, run the sections of an INI job file, the other\n");
+	printf("   options are the defaults of every section\n");
+	printf("\n");
+	printf("job file:\n");
+	printf("   [global]            defaults of the following sections\n");
+	printf("   run = serial        sections one after another or 'parallel'\n");
+	printf("   [name]              one workload, keys as the options:\n");
+	printf("   path, file, buffer, count, loop, threads, engine, depth,\n");
+	printf("   mode, pattern, runtime, rate, iops, interval, cache,\n");
+	printf("   sweep, fanout, trace = value\n");
+	printf("   read, write, sync, direct, verify, pipeline, time, pool = yes|no\n");
+	printf("   e.g. file = r fmin=4m fmax=20m\n");
+	printf("\n");
+	printf("output lines:\n");
+	printf("   I, J    test file and job section\n");
+	printf("   W, R    write and read pass, V their --interval samples\n");
+	printf("   C, L    copy methods and commit log passes\n");
+	printf("   M, T    meta phases and replay directions\n");
+	printf("   D, U    device counters and thread CPU time\n");
+	printf("   B, K    sweep points and knees\n");
+	printf("   A, E    workers aggregate and elapsed total\n");
+	printf("   S, P, G M/S summary, --arena buffers and --compare\n");
+	printf("\n");
+}
+
+/* program options */
+struct option_t {
+	const char *disk;
+	char *buff_size, *file_size;
+	int counts;
+	long loop;
+	int threads;
+	int mode;
+	bool rd, wr;
+	bool fsync, direct, rt_sched;
+	bool verify, timei;
+	/* parsed lengths */
+	long long f_len, f_min, f_max;
+	long long b_len, b_min, b_max;
+	bool rand_file_size, rand_buff_size;
+	ulong f_flags;
+	long runtime;		/* sec, 0 runs counts and loops */
+	u64 rate_bps, rate_iops;
+	struct file_param fp;
+	struct disk_geo geo;
+	long long region;	/* block device, bytes per test index */
+	long long avail;	/* free bytes at start */
+	const char *name;	/* job file section */
+	const char *job;	/* --job file */
+	const char *json, *csv;	/* machine readable result files */
+	const char *save, *compare;	/* baseline files */
+	double tol_mbs, tol_lat;	/* --tolerance, percent */
+	struct results res;
+	int ival_ms;		/* interval series period, 0 none */
+	const char *ival_log;	/* interval series CSV file */
+	bool pool;		/* preallocated files, overwritten in place */
+	long long pool_size;	/* bytes per pool file */
+	bool sweep;		/* buffer length sweep */
+	long long sweep_len[SWEEP_FILES];	/* file lengths, 0 is -f */
+	int sweep_num;
+	int meta_files, fanout;	/* meta mode, files and dirs per count */
+	char dstat[64];		/* device counters file of the path */
+	bool dstat_shared;	/* a parallel job uses the device too */
+	int arena;		/* ARENA_xxx, process wide */
+	const char *trace_file;	/* replay mode */
+	struct trace trace;
+	bool replay_fast;	/* as fast as possible, not the trace time */
+	/* run state, owned by the running workers */
+	int work_next;
+	bool work_stop;
+	u64 work_deadline;	/* --runtime end, nsec */
+	struct rate rate;
+} option = {
+	.disk = DISK_PATH,
+	.counts = DISK_COUNT,
+	.threads = 1,
+	.rd = false,
+	.wr = false,
+	.loop = 0,
+	.fsync = true,
+	.direct = true,
+	.rt_sched = false,
+	.verify = true,
+	.timei = true,
+	.f_len = FILE_DEF_SIZE,
+	.f_min = FILE_MIN_SIZE,
+	.f_max = FILE_MAX_SIZE,
+	.b_len = BUFFER_DEF_SIZE,
+	.b_min = BUFFER_MIN_SIZE,
+	.b_max = BUFFER_MAX_SIZE,
+	.f_flags = FILE_O_SYNC | FILE_O_DIRECT,
+	.fp = {
+		.engine = IO_ENGINE_SYNC,
+		.depth = URING_DEF_DEPTH,
+		.mix = MIX_DEF_READ,
+	},
+	.meta_files = META_DEF_FILES,
+	.fanout = META_DEF_FANOUT,
+	.tol_mbs = BASE_TOL_MBS,
+	.tol_lat = BASE_TOL_LAT,
+};
+
+/* worker thread context */
+struct worker_t {
+	pthread_t thread;
+	int id;
+	struct option_t *op;
+	int count;
+	int files;
+	long long w_length, r_length;
+	u64 w_time, r_time;
+	long long m_ops[META_OPS];	/* meta mode */
+	u64 m_time[META_OPS];
+	u64 usr, sys, v_cpu;	/* thread and verify CPU time, usec */
+	int cpu;		/* last CPU the worker ran on */
+	int ret;
+};
+
+static pthread_mutex_t work_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t print_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *ival_log;		/* --interval-log, under print_lock */
+
+static const struct option long_options[] = {
+	{ "runtime", required_argument, NULL, OPT_RUNTIME },
+	{ "rate", required_argument, NULL, OPT_RATE },
+	{ "iops", required_argument, NULL, OPT_IOPS },
+	{ "job", required_argument, NULL, OPT_JOB },
+	{ "json", required_argument, NULL, OPT_JSON },
+	{ "csv", required_argument, NULL, OPT_CSV },
+	{ "interval", required_argument, NULL, OPT_INTERVAL },
+	{ "interval-log", required_argument, NULL, OPT_INTERVAL_LOG },
+	{ "pool", no_argument, NULL, OPT_POOL },
+	{ "cache", required_argument, NULL, OPT_CACHE },
+	{ "sweep", optional_argument, NULL, OPT_SWEEP },
+	{ "fanout", required_argument, NULL, OPT_FANOUT },
+	{ "cpu", required_argument, NULL, OPT_CPU },
+	{ "sched", required_argument, NULL, OPT_SCHED },
+	{ "arena", optional_argument, NULL, OPT_ARENA },
+	{ "trace", required_argument, NULL, OPT_TRACE },
+	{ "save", required_argument, NULL, OPT_SAVE },
+	{ "compare", required_argument, NULL, OPT_COMPARE },
+	{ "tolerance", required_argument, NULL, OPT_TOLERANCE },
+	{ NULL, 0, NULL, 0 },
+};
+
+/* number with k/m/g (1024 based) suffix */
+static u64 parse_size(const char *str)
+{
+	char *end;
+	u64 v = strtoull(str, &end, 10);
+
+	switch (*end) {
+	case 'k': case 'K':
+		return v * KBYTE;
+	case 'm': case 'M':
+		return v * MBYTE;
+	case 'g': case 'G':
+		return v * MBYTE * KBYTE;
+	default:
+		return v;
+	}
+}
+
+/* seconds with s/m/h suffix */
+static long parse_runtime(const char *str)
+{
+	char *end;
+	long v = strtol(str, &end, 10);
+
+	switch (*end) {
+	case 'h': case 'H':
+		return v * 3600;
+	case 'm': case 'M':
+		return v * 60;
+	case '\0': case 's': case 'S':
+		return v;
+	default:
+		return -EINVAL;
+	}
+}
+
+/* -e sync|uring|mmap[,populate][,seq|rand|willneed] */
+static int parse_engine(const char *str, struct file_param *fp)
+{
+	char buf[128], *tok, *save = NULL;
+
+	snprintf(buf, sizeof(buf), "%s", str);
+
+	tok = strtok_r(buf, ",", &save);
+	if (!tok)
+		return -EINVAL;
+
+	if (!strcmp(tok, "sync"))
+		fp->engine = IO_ENGINE_SYNC;
+	else if (!strcmp(tok, "uring"))
+		fp->engine = IO_ENGINE_URING;
+	else if (!strcmp(tok, "mmap"))
+		fp->engine = IO_ENGINE_MMAP;
+	else
+		return -EINVAL;
+
+	while ((tok = strtok_r(NULL, ",", &save))) {
+		if (fp->engine != IO_ENGINE_MMAP)
+			return -EINVAL;
+
+		if (!strcmp(tok, "populate"))
+			fp->populate = true;
+		else if (!strcmp(tok, "seq"))
+			fp->advise = MADV_SEQUENTIAL;
+		else if (!strcmp(tok, "rand"))
+			fp->advise = MADV_RANDOM;
+		else if (!strcmp(tok, "willneed"))
+			fp->advise = MADV_WILLNEED;
+		else
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* cpu list 'n,n-m,..' */
+static int parse_cpus(const char *str, cpu_set_t *set)
+{
+	char buf[128], *tok, *save = NULL;
+	int a, b;
+
+	snprintf(buf, sizeof(buf), "%s", str);
+	CPU_ZERO(set);
+
+	for (tok = strtok_r(buf, ",", &save); tok;
+	     tok = strtok_r(NULL, ",", &save)) {
+		switch (sscanf(tok, "%d-%d", &a, &b)) {
+		case 1:
+			b = a;
+			break;
+		case 2:
+			break;
+		default:
+			return -EINVAL;
+		}
+
+		if (a < 0 || b < a || b >= CPU_SETSIZE)
+			return -EINVAL;
+
+		for (; a <= b; a++)
+			CPU_SET(a, set);
+	}
+
+	return CPU_COUNT(set) ? 0 : -EINVAL;
+}
+
+/* --cpu role=list, --sched role=other|batch|fifo|rr[:priority] */
+static int parse_role(const char *str, bool sched)
+{
+	struct cpu_role *r = NULL;
+	const char *val = strchr(str, '=');
+	char policy[16];
+	int i, prio;
+
+	if (!val)
+		return -EINVAL;
+
+	for (i = 0; i < ROLE_NUM; i++) {
+		if (!strncmp(str, role_name[i], val - str) &&
+		    strlen(role_name[i]) == (size_t)(val - str))
+			r = &cpu_roles[i];
+	}
+
+	if (!r)
+		return -EINVAL;
+
+	val++;
+	if (!sched) {
+		r->cpus = val;
+		return parse_cpus(val, &r->set);
+	}
+
+	i = sscanf(val, "%15[a-z]:%d", policy, &prio);
+	if (i < 1)
+		return -EINVAL;
+
+	if (!strcmp(policy, "other"))
+		r->policy = SCHED_NORMAL;
+	else if (!strcmp(policy, "batch"))
+		r->policy = SCHED_BATCH;
+	else if (!strcmp(policy, "fifo"))
+		r->policy = SCHED_FIFO;
+	else if (!strcmp(policy, "rr"))
+		r->policy = SCHED_RR;
+	else
+		return -EINVAL;
+
+	/* nice 0 or the top realtime priority as -n */
+	if (i < 2)
+		prio = r->policy == SCHED_FIFO || r->policy == SCHED_RR ?
+		       99 : 0;
+
+	r->sched = val;
+	r->priority = prio;
+
+	return 0;
+}
+
+/* --cache cold|warm */
+static int parse_cache(const char *str, struct file_param *fp)
+{
+	if (!strcmp(str, "cold"))
+		fp->cache = FILE_CACHE_COLD;
+	else if (!strcmp(str, "warm"))
+		fp->cache = FILE_CACHE_WARM;
+	else
+		return -EINVAL;
+
+	return 0;
+}
+
+/* --tolerance n[,m], M/S and latency percent */
+static int parse_tolerance(const char *str, struct option_t *op)
+{
+	char *end;
+
+	op->tol_mbs = strtod(str, &end);
+	if (*end == ',')
+		op->tol_lat = strtod(end + 1, &end);
+
+	if (*end || op->tol_mbs < 0 || op->tol_lat < 0)
+		return -EINVAL;
+
+	return 0;
+}
+
+/* --sweep[=n,n,..], file lengths with k/m/g, none sweeps -f */
+static int parse_sweep(const char *str, struct option_t *op)
+{
+	char buf[256], *tok, *save = NULL;
+
+	op->sweep = true;
+	op->sweep_num = 0;
+	if (!str)
+		return 0;
+
+	snprintf(buf, sizeof(buf), "%s", str);
+
+	for (tok = strtok_r(buf, ",", &save); tok;
+	     tok = strtok_r(NULL, ",", &save)) {
+		if (op->sweep_num == SWEEP_FILES)
+			return -EINVAL;
+
+		op->sweep_len[op->sweep_num] = parse_size(tok);
+		if (op->sweep_len[op->sweep_num] < SWEEP_MIN)
+			return -EINVAL;
+		op->sweep_num++;
+	}
+
+	return 0;
+}
+
+/* -d seq|rand|comp=n|dedup=n|seed=n, comma separated */
+static int parse_pattern(const char *str, struct pattern *pat)
+{
+	char buf[128], *tok, *save = NULL;
+
+	snprintf(buf, sizeof(buf), "%s", str);
+	memset(pat, 0, sizeof(*pat));
+
+	for (tok = strtok_r(buf, ",", &save); tok;
+	     tok = strtok_r(NULL, ",", &save)) {
+		if (!strcmp(tok, "seq")) {
+			pat->type = PATTERN_SEQ;
+		} else if (!strcmp(tok, "rand")) {
+			pat->type = PATTERN_GEN;
+		} else if (!strncmp(tok, "comp=", 5)) {
+			pat->type = PATTERN_GEN;
+			pat->compress = atoi(tok + 5);
+		} else if (!strncmp(tok, "dedup=", 6)) {
+			pat->type = PATTERN_GEN;
+			pat->dedup = atoi(tok + 6);
+		} else if (!strncmp(tok, "seed=", 5)) {
+			pat->type = PATTERN_GEN;
+			pat->seed = strtoull(tok + 5, NULL, 0);
+		} else {
+			return -EINVAL;
+		}
+	}
+
+	if (pat->compress < 0 || pat->compress > 100 ||
+	    pat->dedup < 0 || pat->dedup > 100)
+		return -EINVAL;
+
+	return 0;
+}
+
+/*
+ * -m seq|rand|copy|mix[=n]|commit[=fsync|fdatasync|dsync]|meta[=n]|
+ *    replay[=fast]
+ */
+static int parse_mode(const char *str, struct option_t *op)
+{
+	if (!strcmp(str, "seq")) {
+		op->mode = TEST_MODE_SEQ;
+	} else if (!strcmp(str, "rand")) {
+		op->mode = TEST_MODE_RAND;
+	} else if (!strcmp(str, "copy")) {
+		op->mode = TEST_MODE_COPY;
+	} else if (!strcmp(str, "mix")) {
+		op->mode = TEST_MODE_MIX;
+	} else if (!strncmp(str, "mix=", 4)) {
+		op->mode = TEST_MODE_MIX;
+		op->fp.mix = atoi(str + 4);
+		if (op->fp.mix < 1 || op->fp.mix > 99)
+			return -EINVAL;
+	} else if (!strcmp(str, "commit") || !strcmp(str, "commit=fdatasync")) {
+		op->mode = TEST_MODE_COMMIT;
+		op->fp.commit = COMMIT_FDATASYNC;
+	} else if (!strcmp(str, "commit=fsync")) {
+		op->mode = TEST_MODE_COMMIT;
+		op->fp.commit = COMMIT_FSYNC;
+	} else if (!strcmp(str, "commit=dsync")) {
+		op->mode = TEST_MODE_COMMIT;
+		op->fp.commit = COMMIT_DSYNC;
+	} else if (!strcmp(str, "replay")) {
+		op->mode = TEST_MODE_REPLAY;
+		op->replay_fast = false;
+	} else if (!strcmp(str, "replay=fast")) {
+		op->mode = TEST_MODE_REPLAY;
+		op->replay_fast = true;
+	} else if (!strcmp(str, "meta")) {
+		op->mode = TEST_MODE_META;
+	} else if (!strncmp(str, "meta=", 5)) {
+		op->mode = TEST_MODE_META;
+		op->meta_files = atoi(str + 5);
+		if (op->meta_files < 1)
+			return -EINVAL;
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void parse_options(int argc, char **argv, struct option_t *op)
+{
+	int opt;
+
+	while (-1 != (opt = getopt_long(argc, argv,
+					"hrwp:b:f:c:l:j:e:q:m:d:Pstnv",
+					long_options, NULL))) {
+		switch (opt) {
+		case 'h':
+			print_usage(); exit(1);
+			break;
+		case 'p':
+			op->disk = optarg;
+			break;
+		case 'r':
+			op->rd = true;
+			break;
+		case 'w':
+			op->wr = true;
+			break;
+		case 'b':
+			op->buff_size = optarg;
+			break;
+		case 'f':
+			op->file_size = optarg;
+			break;
+		case 'c':
+			op->counts = atoi(optarg);
+			break;
+		case 'l':
+			op->loop = atoi(optarg);
+			break;
+		case 'j':
+			op->threads = atoi(optarg);
+			break;
+		case 'e':
+			if (parse_engine(optarg, &op->fp) < 0) {
+				fprintf(stderr,
+					"Fail, unknown engine %s\n", optarg);
+				print_usage(), exit(1);
+			}
+			break;
+		case 'q':
+			op->fp.depth = atoi(optarg);
+			break;
+		case 'P':
+			op->fp.pipeline = true;
+			break;
+		case 'd':
+			if (parse_pattern(optarg, &op->fp.pat) < 0) {
+				fprintf(stderr,
+					"Fail, unknown pattern %s\n", optarg);
+				print_usage(), exit(1);
+			}
+			break;
+		case 'm':
+			if (parse_mode(optarg, op) < 0) {
+				fprintf(stderr,
+					"Fail, unknown mode %s\n", optarg);
+				print_usage(), exit(1);
+			}
+			break;
+		case 's':
+			op->fsync = false;
+			op->direct = false;
+			break;
+		case 't':
+			op->timei = false;
+			break;
+		case 'n':
+			op->rt_sched = true;
+			break;
+		case 'v':
+			op->verify = false;
+			break;
+		case OPT_RUNTIME:
+			op->runtime = parse_runtime(optarg);
+			if (op->runtime <= 0) {
+				fprintf(stderr,
+					"Fail, invalid runtime %s\n", optarg);
+				print_usage(), exit(1);
+			}
+			break;
+		case OPT_RATE:
+			op->rate_bps = parse_size(optarg);
+			break;
+		case OPT_IOPS:
+			op->rate_iops = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_JOB:
+			op->job = optarg;
+			break;
+		case OPT_JSON:
+			op->json = optarg;
+			break;
+		case OPT_CSV:
+			op->csv = optarg;
+			break;
+		case OPT_INTERVAL:
+			op->ival_ms = atoi(optarg);
+			break;
+		case OPT_INTERVAL_LOG:
+			op->ival_log = optarg;
+			break;
+		case OPT_POOL:
+			op->pool = true;
+			break;
+		case OPT_CACHE:
+			if (parse_cache(optarg, &op->fp) < 0)
+				print_usage(), exit(1);
+			break;
+		case OPT_SWEEP:
+			if (parse_sweep(optarg, op) < 0)
+				print_usage(), exit(1);
+			break;
+		case OPT_FANOUT:
+			op->fanout = atoi(optarg);
+			break;
+		case OPT_TRACE:
+			op->trace_file = optarg;
+			break;
+		case OPT_SAVE:
+			op->save = optarg;
+			break;
+		case OPT_COMPARE:
+			op->compare = optarg;
+			break;
+		case OPT_TOLERANCE:
+			if (parse_tolerance(optarg, op) < 0)
+				print_usage(), exit(1);
+			break;
+		case OPT_ARENA:
+			if (!optarg)
+				op->arena = ARENA_ON;
+			else if (!strcmp(optarg, "thp"))
+				op->arena = ARENA_THP;
+			else if (!strcmp(optarg, "huge"))
+				op->arena = ARENA_HUGE;
+			else
+				print_usage(), exit(1);
+			break;
+		case OPT_CPU:
+		case OPT_SCHED:
+			if (parse_role(optarg, opt == OPT_SCHED) < 0)
+				print_usage(), exit(1);
+			break;
+		default:
+			print_usage(), exit(1);
+			break;
+		}
+	}
+}
+
+/* format one 'W :' or 'R :' result line */
+static int test_report(char *out, int size, const char *name,
+		       long long f_len, long long b_len, long long length,
+		       u64 time, const struct file_stat *st,
+		       const struct file_param *fp)
+{
+	int n;
+
+	n = snprintf(out, size, "%s : %3lld.%06lld, %lld/%lld (%3lld.%6lld M/S)",
+		name, time ? SE(time) : 0, time ? US(time) : 0, f_len, b_len,
+		time ? MBS(length, time) : 0, time ? MBU(length, time) : 0);
+
+	if (fp->random && time && st->ios)
+		n += snprintf(out + n, size - n, " %lld IOPS, avg %llu.%01llu us",
+			(st->ios * 1000000) / time,
+			NS_US(hist_mean(&st->lat)), NS_UF(hist_mean(&st->lat)));
+
+	if (time && st->v_time)
+		n += snprintf(out + n, size - n, " verify %3lld.%6lld M/S",
+			MBS(st->v_length, (st->v_time / 1000) + 1),
+			MBU(st->v_length, (st->v_time / 1000) + 1));
+
+	if (time && st->lat.total) {
+		const struct hist *h = &st->lat;
+
+		n += snprintf(out + n, size - n,
+			" [p50 %llu.%01llu p99 %llu.%01llu p99.9 %llu.%01llu max %llu.%01llu us]",
+			NS_US(hist_percentile(h, 50.0)),
+			NS_UF(hist_percentile(h, 50.0)),
+			NS_US(hist_percentile(h, 99.0)),
+			NS_UF(hist_percentile(h, 99.0)),
+			NS_US(hist_percentile(h, 99.9)),
+			NS_UF(hist_percentile(h, 99.9)),
+			NS_US(h->max), NS_UF(h->max));
+	}
+
+	n += snprintf(out + n, size - n, "\n");
+
+	return n;
+}
+
+/*
+ * format the 'D :' device line of a pass, 'write' selects the counters
+ * of the direction. the ratio is device bytes per application byte,
+ * above 1 is file system amplification, below 1 page cache hits.
+ * util, the average queue and the requests in flight at the end are
+ * of the device, both directions. IOPS is per pass 'time', util and
+ * queue per the time between the counter snapshots, util is capped at
+ * 100% as the msec io ticks are coarse for short passes.
+ */
+static int test_dev(char *out, int size, bool write, long long length,
+		    u64 time, const struct file_stat *st)
+{
+	const struct dstat *ds = &st->dev;
+	unsigned long long ios, merges, bytes, ticks;
+	double util;
+
+	if (!st->has_dev || !time || !st->dev_time)
+		return 0;
+
+	util = (double)ds->io_ticks * 100000 / st->dev_time;
+	if (util > 100)
+		util = 100;
+
+	ios = write ? ds->wr_ios : ds->rd_ios;
+	merges = write ? ds->wr_merges : ds->rd_merges;
+	bytes = (write ? ds->wr_sectors : ds->rd_sectors) * 512;
+	ticks = write ? ds->wr_ticks : ds->rd_ticks;
+
+	return snprintf(out, size,
+		"D : %c %llu ios (%llu IOPS), merges %llu, %llu byte (ratio %.3f), await %.3f ms, util %.1f%%, queue %.2f, in flight %llu\n",
+		write ? 'W' : 'R', ios, ios * 1000000 / time, merges, bytes,
+		length ? (double)bytes / length : 0,
+		ios ? (double)ticks / ios : 0, util,
+		(double)ds->queue_ticks * 1000 / st->dev_time, ds->in_flight);
+}
+
+/*
+ * format a 'T :' replay line of one direction, the replayed latency
+ * and the traced one when the trace has it
+ */
+static int test_trace(char *out, int size, const char *name,
+		      const struct replay_stat *rs, int i)
+{
+	const struct hist *h = &rs->lat[i], *o = &rs->orig[i];
+	int n;
+
+	n = snprintf(out, size,
+		"T : %s %lld ios, %lld byte (%3lld.%6lld M/S) [p50 %llu.%01llu p99 %llu.%01llu max %llu.%01llu us]",
+		name, rs->ios[i], rs->bytes[i],
+		rs->time ? MBS(rs->bytes[i], rs->time) : 0,
+		rs->time ? MBU(rs->bytes[i], rs->time) : 0,
+		NS_US(hist_percentile(h, 50.0)),
+		NS_UF(hist_percentile(h, 50.0)),
+		NS_US(hist_percentile(h, 99.0)),
+		NS_UF(hist_percentile(h, 99.0)),
+		NS_US(h->max), NS_UF(h->max));
+
+	if (o->total)
+		n += snprintf(out + n, size - n,
+			" trace [p50 %llu.%01llu p99 %llu.%01llu max %llu.%01llu us]",
+			NS_US(hist_percentile(o, 50.0)),
+			NS_UF(hist_percentile(o, 50.0)),
+			NS_US(hist_percentile(o, 99.0)),
+			NS_UF(hist_percentile(o, 99.0)),
+			NS_US(o->max), NS_UF(o->max));
+
+	n += snprintf(out + n, size - n, "\n");
+
+	return n;
+}
+
+/* record one test of the file 'index' to the results of the run */
+static void test_result(struct worker_t *w, int index, const char *op,
+			long long f_len, long long b_len, long long length,
+			u64 time, const struct file_stat *st)
+{
+	struct result r;
+
+	memset(&r, 0, sizeof(r));
+	snprintf(r.op, sizeof(r.op), "%s", op);
+	r.loop = w->count;
+	r.index = index;
+	r.f_length = f_len;
+	r.b_length = b_len;
+	r.length = length;
+	r.usec = time;
+	r.ios = st->ios;
+	r.mbs = time ? (double)length * 1000000.0 / time / MBYTE : 0;
+
+	if (time && st->lat.total) {
+		r.p50 = hist_percentile(&st->lat, 50.0);
+		r.p99 = hist_percentile(&st->lat, 99.0);
+		r.max = st->lat.max;
+	}
+
+	if (results_add(&w->op->res, &r))
+		fprintf(stderr, "Fail, result of %s %d\n", op, index);
+}
+
+/* interval series of one pass, to the CSV log or as 'V :' lines */
+static void test_ival(struct worker_t *w, int index, const char *op,
+		      const struct ival *iv)
+{
+	const struct ival_sample *s;
+	long long iops;
+	double mbs;
+	int i;
+
+	if (!iv)
+		return;
+
+	for (i = 0; i < iv->num; i++) {
+		s = &iv->s[i];
+		mbs = s->dt ? (double)s->bytes * 1e9 / s->dt / MBYTE : 0;
+		iops = s->dt ? s->ios * 1000000000LL / (long long)s->dt : 0;
+
+		if (ival_log)
+			fprintf(ival_log, "%s,%s,%d,%d,%llu,%lld,%.6f,%lld,%llu\n",
+				w->op->name ? w->op->name : "", op,
+				w->count, index, s->t / 1000, s->bytes, mbs,
+				iops, s->max);
+		else
+			printf("V : %c %6llu ms %10lld byte (%9.3f M/S) %7lld IOPS max %llu.%01llu us\n",
+				op[0] - 'a' + 'A', s->t / 1000000, s->bytes,
+				mbs, iops, NS_US(s->max), NS_UF(s->max));
+	}
+}
+
+/*
+ * run write and read test for one file 'test.<index>.txt',
+ * the report lines are printed at once so threads do not interleave.
+ */
+static int test_file(struct worker_t *w, int index)
+{
+	struct option_t *op = w->op;
+	struct file_param fp = op->fp;
+	const char *disk = op->disk;
+	long long f_len = op->f_len, b_len = op->b_len;
+	char file[256], name[300], out[1024];
+	struct ival iv[2], *wiv = NULL, *riv = NULL;
+	int n = 0, ret = 0;
+
+	if (op->ival_ms) {
+		ival_init(&iv[0], (u64)op->ival_ms * 1000000ULL);
+		ival_init(&iv[1], (u64)op->ival_ms * 1000000ULL);
+		wiv = &iv[0], riv = &iv[1];
+	}
+
+	if (op->rand_buff_size)
+		RAND_SIZE(op->b_min, op->b_max, op->fp.align, b_len);
+
+	if (op->rand_file_size)
+		RAND_SIZE(op->f_min, op->f_max, op->f_min, f_len);
+
+	if (op->geo.blkdev) {
+		/* every index owns one region of the device, no free space */
+		snprintf(file, sizeof(file), "%s", op->disk);
+		fp.base = (long long)index * op->region;
+		disk = NULL;
+		snprintf(name, sizeof(name), "%s@0x%llx",
+			 basename(file), fp.base);
+	} else if (op->mode == TEST_MODE_META) {
+		sprintf(file, "%s/meta.%d", op->disk, index);
+		snprintf(name, sizeof(name), "%s", basename(file));
+	} else if (op->mode == TEST_MODE_REPLAY) {
+		sprintf(file, "%s/replay.%d.txt", op->disk, index);
+		snprintf(name, sizeof(name), "%s", basename(file));
+	} else {
+		sprintf(file, "%s/%s.%d.txt", op->disk, FILE_PREFIX, index);
+		snprintf(name, sizeof(name), "%s", basename(file));
+		/* the pool space is budgeted, never reclaim the pool files */
+		if (op->pool)
+			disk = NULL;
+	}
+
+	if (op->name)
+		n += snprintf(out + n, sizeof(out) - n, "J : %s\n", op->name);
+
+	if (op->threads > 1)
+		n += snprintf(out + n, sizeof(out) - n,
+			      "I : %s, count [%3d/%3d] thread [%d]\n",
+			      name, index, w->count, w->id);
+	else
+		n += snprintf(out + n, sizeof(out) - n,
+			      "I : %s, count [%3d/%3d]\n",
+			      name, index, w->count);
+
+	if (op->mode == TEST_MODE_COPY) {
+		ret = test_copy(disk, file, op->f_flags, f_len, b_len,
+				op->counts, op->verify, &fp,
+				out, sizeof(out), &n);
+		if (ret < 0)
+			goto out;
+
+		w->files++;
+		goto out;
+	}
+
+	if (op->mode == TEST_MODE_MIX) {
+		struct file_stat rs = { .ival = riv }, ws = { .ival = wiv };
+		u64 time = 0, *ptime = op->timei ? &time : NULL;
+
+		ret = test_mix(disk, file, op->f_flags, f_len, b_len,
+			       op->counts, op->verify, ptime, &fp, &rs, &ws);
+		if (ret < 0)
+			goto out;
+
+		/* both directions share the pass time */
+		n += test_report(out + n, sizeof(out) - n, "W",
+				 f_len, b_len, ws.length, time, &ws, &fp);
+		n += test_report(out + n, sizeof(out) - n, "R",
+				 f_len, b_len, rs.length, time, &rs, &fp);
+		test_result(w, index, "write", f_len, b_len, ws.length,
+			    time, &ws);
+		test_result(w, index, "read", f_len, b_len, rs.length,
+			    time, &rs);
+
+		w->w_length += ws.length, w->w_time += time;
+		w->r_length += rs.length, w->r_time += time;
+		w->files++;
+		goto out;
+	}
+
+	if (op->mode == TEST_MODE_REPLAY) {
+		struct replay_stat *rs = malloc(sizeof(*rs));
+		struct file_stat st;
+		int i;
+
+		if (!rs) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		ret = test_replay(disk, file, op->f_flags, f_len, b_len,
+				  op->counts, &op->trace, op->replay_fast,
+				  &fp, rs);
+		if (ret < 0) {
+			free(rs);
+			goto out;
+		}
+
+		for (i = 0; i < 2 && op->timei; i++) {
+			if (!rs->ios[i])
+				continue;
+
+			n += test_trace(out + n, sizeof(out) - n, i ? "W" : "R",
+					rs, i);
+
+			memset(&st, 0, sizeof(st));
+			st.ios = rs->ios[i];
+			st.lat = rs->lat[i];
+			test_result(w, index, i ? "write" : "read", f_len, 0,
+				    rs->bytes[i], rs->time, &st);
+		}
+
+		if (op->timei)
+			n += snprintf(out + n, sizeof(out) - n,
+				"T : time %llu.%06llu, trace %llu.%06llu, flush %lld",
+				SE(rs->time), US(rs->time),
+				SE(op->trace.span / 1000),
+				US(op->trace.span / 1000), rs->flush);
+
+		/* how late the requests went out against the trace */
+		if (op->timei && !op->replay_fast)
+			n += snprintf(out + n, sizeof(out) - n,
+				", lag p50 %llu.%01llu p99 %llu.%01llu max %llu.%01llu us",
+				NS_US(hist_percentile(&rs->lag, 50.0)),
+				NS_UF(hist_percentile(&rs->lag, 50.0)),
+				NS_US(hist_percentile(&rs->lag, 99.0)),
+				NS_UF(hist_percentile(&rs->lag, 99.0)),
+				NS_US(rs->lag.max), NS_UF(rs->lag.max));
+
+		if (op->timei)
+			n += snprintf(out + n, sizeof(out) - n, "\n");
+
+		w->w_length += rs->bytes[1], w->w_time += rs->time;
+		w->r_length += rs->bytes[0], w->r_time += rs->time;
+		w->files++;
+		free(rs);
+		goto out;
+	}
+
+	if (op->mode == TEST_MODE_META) {
+		struct file_stat st[META_OPS];
+		u64 time[META_OPS] = { 0, }, *ptime = op->timei ? time : NULL;
+		int i;
+
+		memset(st, 0, sizeof(st));
+
+		ret = test_space(disk, op->counts,
+				 (long long)op->meta_files * b_len);
+		if (ret < 0)
+			goto out;
+
+		ret = file_meta(file, op->f_flags, op->meta_files, op->fanout,
+				b_len, ptime, &fp, st);
+		if (ret < 0)
+			goto out;
+
+		for (i = 0; i < META_OPS && ptime; i++) {
+			const struct hist *h = &st[i].lat;
+
+			n += snprintf(out + n, sizeof(out) - n,
+				"M : %-6s %3lld.%06lld, %d files (%lld op/s) [p50 %llu.%01llu p99 %llu.%01llu max %llu.%01llu us]\n",
+				meta_name[i], SE(time[i]), US(time[i]),
+				op->meta_files,
+				time[i] ? st[i].ios * 1000000 / time[i] : 0,
+				NS_US(hist_percentile(h, 50.0)),
+				NS_UF(hist_percentile(h, 50.0)),
+				NS_US(hist_percentile(h, 99.0)),
+				NS_UF(hist_percentile(h, 99.0)),
+				NS_US(h->max), NS_UF(h->max));
+			test_result(w, index, meta_name[i], 0, b_len,
+				    st[i].ios * b_len, time[i], &st[i]);
+
+			w->m_ops[i] += st[i].ios;
+			w->m_time[i] += time[i];
+		}
+		w->files++;
+		goto out;
+	}
+
+	if (op->mode == TEST_MODE_COMMIT) {
+		struct file_stat st = { .ival = wiv };
+		struct file_param cfp = fp;
+		long long length = 0;
+		u64 time = 0, *ptime = op->timei ? &time : NULL;
+
+		ret = test_commit(disk, file, op->f_flags, f_len, b_len,
+				  &length, op->counts, ptime, &fp, &st);
+		if (ret < 0)
+			goto out;
+
+		/* IOPS of the report are the commits per second */
+		cfp.random = true;
+		n += test_report(out + n, sizeof(out) - n, "L",
+				 f_len, b_len, length, time, &st, &cfp);
+		test_result(w, index, "commit", f_len, b_len, length, time,
+			    &st);
+
+		w->w_length += length;
+		w->w_time += time;
+		w->files++;
+		goto out;
+	}
+
+	if (op->wr) {
+		struct file_stat st = { .ival = wiv };
+		long long length = 0;
+		u64 time = 0, *ptime = op->timei ? &time : NULL;
+
+		ret = test_write(disk, file, op->f_flags,
+				 f_len, b_len, &length,
+				 op->counts, op->verify, ptime, &fp, &st);
+		if (ret < 0)
+			goto out;
+
+		n += test_report(out + n, sizeof(out) - n, "W",
+				 f_len, b_len, length, time, &st, &op->fp);
+		n += test_dev(out + n, sizeof(out) - n, true, length, time,
+			      &st);
+		test_result(w, index, "write", f_len, b_len, length, time,
+			    &st);
+
+		w->w_length += length;
+		w->w_time += time;
+	}
+
+	if (op->rd) {
+		struct file_stat st = { .ival = riv };
+		long long length = 0;
+		u64 time = 0, *ptime = op->timei ? &time : NULL;
+
+		ret = test_read(disk, file, op->f_flags,
+				f_len, b_len, &length,
+				op->counts, op->verify, ptime, &fp, &st);
+		if (ret < 0)
+			goto out;
+
+		n += test_report(out + n, sizeof(out) - n, "R",
+				 f_len, b_len, length, time, &st, &op->fp);
+		n += test_dev(out + n, sizeof(out) - n, false, length, time,
+			      &st);
+		w->v_cpu += st.v_cpu;
+		test_result(w, index, "read", f_len, b_len, length, time,
+			    &st);
+
+		w->r_length += length;
+		w->r_time += time;
+	}
+	w->files++;
+
+out:
+	pthread_mutex_lock(&print_lock);
+	fputs(out, stdout);
+	test_ival(w, index, "write", wiv);
+	test_ival(w, index, "read", riv);
+	fputs("\n", stdout);
+	fflush(stdout);
+	pthread_mutex_unlock(&print_lock);
+
+	if (op->ival_ms) {
+		ival_free(&iv[0]);
+		ival_free(&iv[1]);
+	}
+
+	return ret;
+}
+
+static void *test_worker(void *data)
+{
+	struct worker_t *w = data;
+	struct option_t *op = w->op;
+	u64 usr, sys;
+	int index;
+
+	role_apply(ROLE_IO);
+	thread_cpu(&usr, &sys);
+
+	while (1) {
+		pthread_mutex_lock(&work_lock);
+		if (op->work_deadline && time_ns() >= op->work_deadline)
+			op->work_stop = true;
+		index = op->work_stop ? op->counts : op->work_next++;
+		pthread_mutex_unlock(&work_lock);
+
+		if (index >= op->counts)
+			break;
+
+		w->ret = test_file(w, index);
+		if (w->ret < 0) {
+			pthread_mutex_lock(&work_lock);
+			op->work_stop = true;
+			pthread_mutex_unlock(&work_lock);
+			break;
+		}
+	}
+
+	thread_cpu(&w->usr, &w->sys);
+	w->usr -= usr, w->sys -= sys;
+	w->cpu = sched_getcpu();
+
+	return NULL;
+}
+
+static void print_worker(const char *name, int files,
+			 long long w_length, u64 w_time,
+			 long long r_length, u64 r_time)
+{
+	printf("%s : files %d", name, files);
+	if (w_time)
+		printf(", W %lld byte (%3lld.%6lld M/S)", w_length,
+			MBS(w_length, w_time), MBU(w_length, w_time));
+	if (r_time)
+		printf(", R %lld byte (%3lld.%6lld M/S)", r_length,
+			MBS(r_length, r_time), MBU(r_length, r_time));
+	printf("\n");
+}
+
+static void print_cpu(const char *name, const struct worker_t *w)
+{
+	printf("U : %s usr %llu.%03llu ms, sys %llu.%03llu ms",
+		name, w->usr / 1000, w->usr % 1000,
+		w->sys / 1000, w->sys % 1000);
+	if (w->v_cpu)
+		printf(", verify %llu.%03llu ms",
+			w->v_cpu / 1000, w->v_cpu % 1000);
+	printf(", cpu %d\n", w->cpu);
+}
+
+/* meta mode, op/s of all workers, the slowest one bounds a phase */
+static void print_meta(const struct worker_t *workers, int threads)
+{
+	int i, op;
+
+	printf("A : meta");
+	for (op = 0; op < META_OPS; op++) {
+		long long ops = 0;
+		u64 time = 0;
+
+		for (i = 0; i < threads; i++) {
+			ops += workers[i].m_ops[op];
+			if (workers[i].m_time[op] > time)
+				time = workers[i].m_time[op];
+		}
+
+		printf(", %s %lld op/s", meta_name[op],
+			time ? ops * 1000000 / time : 0);
+	}
+	printf("\n");
+}
+
+/*
+ * spread the 'counts' test files over 'threads' workers, every worker
+ * allocates its own buffer and owns the file it is running.
+ */
+static int test_workers(struct option_t *op, int count)
+{
+	struct worker_t *workers;
+	struct role_state main_state;
+	long long w_length = 0, r_length = 0;
+	u64 w_time = 0, r_time = 0;
+	u64 ts = 0, te = 0;
+	int threads = op->threads;
+	int i, files = 0, ret = 0;
+	bool threaded;
+
+	if (threads > op->counts)
+		threads = op->counts;
+
+	threaded = threads > 1;
+
+	workers = calloc(threads, sizeof(*workers));
+	if (!workers)
+		return -ENOMEM;
+
+	op->work_next = 0, op->work_stop = false;
+
+	if (op->timei)
+		RUN_TIME_US(ts);
+
+	for (i = 0; i < threads; i++) {
+		workers[i].id = i;
+		workers[i].op = op;
+		workers[i].count = count;
+
+		/*
+		 * one worker runs in this thread with the io role,
+		 * back to the main one or the startup state after it
+		 */
+		if (!threaded) {
+			role_save(&main_state);
+			test_worker(&workers[i]);
+			role_restore(&main_state);
+			continue;
+		}
+
+		ret = pthread_create(&workers[i].thread, NULL,
+				     test_worker, &workers[i]);
+		if (ret) {
+			fprintf(stderr,
+				"Fail, create thread %d (%d)\n", i, ret);
+			pthread_mutex_lock(&work_lock);
+			op->work_stop = true;
+			pthread_mutex_unlock(&work_lock);
+			threads = i;
+			ret = -ret;
+			break;
+		}
+	}
+
+	if (threaded) {
+		for (i = 0; i < threads; i++)
+			pthread_join(workers[i].thread, NULL);
+	}
+
+	if (op->timei)
+		END_TIME_US(ts, te);
+
+	for (i = 0; i < threads; i++) {
+		struct worker_t *w = &workers[i];
+
+		if (w->ret < 0 && !ret)
+			ret = w->ret;
+
+		files += w->files;
+		w_length += w->w_length;
+		r_length += w->r_length;
+
+		/* workers run side by side, the slowest one bounds the run */
+		if (w->w_time > w_time)
+			w_time = w->w_time;
+		if (w->r_time > r_time)
+			r_time = w->r_time;
+	}
+
+	if (threaded && op->timei) {
+		long long length = w_length + r_length;
+		char name[16];
+
+		/* jobs running at the same time print their own blocks */
+		pthread_mutex_lock(&print_lock);
+		if (op->name)
+			printf("J : %s\n", op->name);
+
+		for (i = 0; i < threads; i++) {
+			struct worker_t *w = &workers[i];
+
+			sprintf(name, "T%d", w->id);
+			print_worker(name, w->files, w->w_length, w->w_time,
+				     w->r_length, w->r_time);
+		}
+
+		for (i = 0; i < threads; i++) {
+			sprintf(name, "T%d", workers[i].id);
+			print_cpu(name, &workers[i]);
+		}
+
+		print_worker("A", files, w_length, w_time, r_length, r_time);
+		if (op->mode == TEST_MODE_META)
+			print_meta(workers, threads);
+		printf("E : %3lld.%06lld, %lld byte (%3lld.%6lld M/S)\n\n",
+			SE(te), US(te), length,
+			te ? MBS(length, te) : 0, te ? MBU(length, te) : 0);
+		fflush(stdout);
+		pthread_mutex_unlock(&print_lock);
+	} else if (op->timei) {
+		pthread_mutex_lock(&print_lock);
+		print_cpu("T0", &workers[0]);
+		printf("\n");
+		fflush(stdout);
+		pthread_mutex_unlock(&print_lock);
+	}
+
+	free(workers);
+
+	return ret;
+}
+
+/*
+ * allocate the test files once for all loops. the space of the missing
+ * blocks is checked before any file is touched, so a full disk fails
+ * here and not with a removed file in the middle of a run.
+ */
+static int test_pool(struct option_t *op)
+{
+	long long len = op->rand_file_size ? op->f_max : op->f_len;
+	long long need = 0, avail;
+	bool warn = false;
+	char file[256];
+	struct stat st;
+	int i, fd;
+
+	for (i = 0; i < op->counts; i++) {
+		sprintf(file, "%s/%s.%d.txt", op->disk, FILE_PREFIX, i);
+		if (stat(file, &st))
+			need += len;
+		else if (st.st_blocks * 512 < len)
+			need += len - st.st_blocks * 512;
+	}
+
+	avail = disk_disk_avail(op->disk, NULL, 0);
+	if (need > avail - SPARE_SIZE) {
+		fprintf(stderr,
+			"No space left for pool %d x %lld, free %lld, req %lld\n",
+			op->counts, len, avail, need + SPARE_SIZE);
+		return -ENOSPC;
+	}
+
+	for (i = 0; i < op->counts; i++) {
+		sprintf(file, "%s/%s.%d.txt", op->disk, FILE_PREFIX, i);
+
+		fd = open(file, O_RDWR | O_CREAT, 0777);
+		if (fd < 0) {
+			fprintf(stderr, "Fail, open %s (%d)\n", file, errno);
+			return -errno;
+		}
+
+		if (fallocate(fd, 0, 0, len) < 0) {
+			if (errno != EOPNOTSUPP) {
+				fprintf(stderr,
+					"Fail, fallocate %s (%d)\n", file, errno);
+				close(fd);
+				return -errno;
+			}
+
+			/* the writes still go in place, only not preallocated */
+			if (!warn)
+				fprintf(stderr,
+					"fallocate not supported, pool not preallocated\n");
+			warn = true;
+		}
+
+		fdatasync(fd);
+		close(fd);
+	}
+
+	op->pool_size = len;
+	op->avail = avail - need;
+
+	return 0;
+}
+
+/*
+ * check and complete the options of one run. 'argc/argv' are searched
+ * for the bmin=/bmax=/fmin=/fmax= words of random lengths.
+ */
+static int test_setup(struct option_t *op, int argc, char **argv)
+{
+	struct stat st;
+	int ret;
+
+	/* makes the test directory before its alignment is probed */
+	if (stat(op->disk, &st) || !S_ISBLK(st.st_mode))
+		op->avail = disk_disk_avail(op->disk, NULL, 0);
+
+	if (disk_geometry(op->disk, &op->geo) < 0)
+		return -EINVAL;
+
+	op->fp.align = op->geo.mem_align > op->geo.off_align ?
+		       op->geo.mem_align : op->geo.off_align;
+
+	/* get buffer length */
+	op->b_len = parse_length(argc, argv, op->buff_size,
+				 &op->b_min, &op->b_max, "bmin=", "bmax=",
+				 &op->rand_buff_size, op->geo.off_align);
+
+	if (!op->rand_buff_size && op->b_len > BUFFER_MAX_SIZE) {
+		fprintf(stderr,
+			"Fail, Invalid buffer %lld, max %d byte\n",
+			op->b_len, BUFFER_MAX_SIZE);
+		return -EINVAL;
+	}
+
+	/* meta mode files are empty without -b */
+	if (!op->b_len && op->mode != TEST_MODE_META)
+		op->b_len = op->mode == TEST_MODE_COMMIT ?
+			    COMMIT_DEF_RECORD : BUFFER_DEF_SIZE;
+
+	op->f_len = parse_length(argc, argv, op->file_size,
+				 &op->f_min, &op->f_max, "fmin=", "fmax=",
+				 &op->rand_file_size, op->geo.off_align);
+
+	if (!op->f_len)
+		op->f_len = op->mode == TEST_MODE_COMMIT ?
+			    COMMIT_DEF_SIZE : FILE_DEF_SIZE;
+
+	if (!op->rd && !op->wr)
+		op->rd = true;
+
+	if (op->sweep) {
+		int i;
+
+		if ((op->mode != TEST_MODE_SEQ && op->mode != TEST_MODE_RAND) ||
+		    !op->timei) {
+			fprintf(stderr,
+				"Fail, sweep runs timed seq or rand mode\n");
+			return -EINVAL;
+		}
+
+		if (!op->sweep_num)
+			op->sweep_len[op->sweep_num++] =
+				op->rand_file_size ? op->f_max : op->f_len;
+
+		for (i = 0; i < op->sweep_num; i++) {
+			if (op->geo.blkdev && op->sweep_len[i] > op->geo.size) {
+				fprintf(stderr,
+					"Fail, sweep file %lld over device %lld byte\n",
+					op->sweep_len[i], op->geo.size);
+				return -EINVAL;
+			}
+		}
+	}
+
+	op->fp.random = op->mode == TEST_MODE_RAND ||
+			op->mode == TEST_MODE_MIX;
+
+	if (op->mode == TEST_MODE_MIX && op->fp.engine == IO_ENGINE_MMAP) {
+		fprintf(stderr, "mix mode runs sync or uring, use sync\n");
+		op->fp.engine = IO_ENGINE_SYNC;
+	}
+
+	op->f_flags = (op->fsync ? FILE_O_SYNC : 0) |
+		      (op->direct ? FILE_O_DIRECT : 0);
+
+	if (op->pool && (op->geo.blkdev || op->sweep ||
+			 (op->mode != TEST_MODE_SEQ &&
+			  op->mode != TEST_MODE_RAND &&
+			  op->mode != TEST_MODE_MIX))) {
+		fprintf(stderr,
+			"pool needs a directory path and a read/write mode\n");
+		op->pool = false;
+	}
+
+	/* random buffer below the sector would fail direct I/O */
+	if ((op->f_flags & FILE_O_DIRECT) && op->b_min < op->geo.off_align)
+		op->b_min = op->geo.off_align;
+
+	if (op->geo.blkdev) {
+		long long len = op->rand_file_size ? op->f_max : op->f_len;
+		long page = sysconf(_SC_PAGESIZE);
+
+		if (op->mode == TEST_MODE_COPY ||
+		    op->mode == TEST_MODE_COMMIT ||
+		    op->mode == TEST_MODE_META) {
+			fprintf(stderr,
+				"Fail, copy, commit and meta mode need a directory path\n");
+			return -EINVAL;
+		}
+
+		/* page aligned regions, mmap maps at the region offset */
+		op->region = (len + page - 1) / page * page;
+		op->avail = op->geo.size;
+
+		if (op->region * op->counts > op->geo.size) {
+			fprintf(stderr,
+				"Fail, %d regions of %lld byte over device %lld byte\n",
+				op->counts, op->region, op->geo.size);
+			return -EINVAL;
+		}
+	}
+
+	if (op->threads < 1)
+		op->threads = 1;
+
+	if (op->fanout < 1)
+		op->fanout = 1;
+
+	if (op->mode == TEST_MODE_REPLAY) {
+		if (!op->trace_file) {
+			fprintf(stderr, "Fail, replay mode needs --trace\n");
+			return -EINVAL;
+		}
+
+		ret = trace_load(op->trace_file, &op->trace);
+		if (ret < 0)
+			return ret;
+	}
+
+	/* the counters are per device, a pass of one worker only */
+	op->fp.dstat = NULL;
+	if (dstat_path(op->disk, op->dstat, sizeof(op->dstat)))
+		op->dstat[0] = '\0';
+	else if (op->threads == 1)
+		op->fp.dstat = op->dstat;
+
+	if (op->fp.depth < 1)
+		op->fp.depth = 1;
+
+	if (op->fp.depth > URING_MAX_DEPTH)
+		op->fp.depth = URING_MAX_DEPTH;
+
+	if (op->fp.engine == IO_ENGINE_URING) {
+		struct uring ring;
+
+		/* probe kernel support once, before any file is opened */
+		ret = uring_init(&ring, op->fp.depth);
+		if (ret) {
+			fprintf(stderr,
+				"io_uring not supported (%d), use sync\n", ret);
+			op->fp.engine = IO_ENGINE_SYNC;
+		} else if (uring_probe(&ring)) {
+			fprintf(stderr,
+				"io_uring has no read/write ops (kernel 5.6+), use sync\n");
+			op->fp.engine = IO_ENGINE_SYNC;
+		}
+		uring_exit(&ring);
+	}
+
+	if (op->pool) {
+		ret = test_pool(op);
+		if (ret < 0)
+			return ret;
+		op->f_flags |= FILE_POOL;
+	}
+
+	results_init(&op->res);
+
+	op->fp.rate = NULL;
+	if (op->rate_bps || op->rate_iops) {
+		rate_init(&op->rate, op->rate_bps, op->rate_iops);
+		op->fp.rate = &op->rate;
+	}
+
+	return 0;
+}
+
+static int test_header(struct option_t *op)
+{
+	char file[256];
+	struct tm *tm;
+	time_t tt;
+	int i;
+
+	time(&tt);
+	tm = localtime(&tt);
+
+	if (!realpath(op->disk, file)) {
+		fprintf(stderr, "Invalid ditectory path for %s\n", op->disk);
+		return -EINVAL;
+	}
+
+	printf("===============================================================\n");
+	if (op->name)
+		printf("Job    : %s\n", op->name);
+	if (op->geo.blkdev)
+		printf("Disk   : '%s' block device, %lld MByte, sector %d/%d byte\n",
+			file, op->geo.size/MBYTE, op->geo.lbs, op->geo.pbs);
+	else
+		printf("Disk   : '%s'\n", file);
+	if (op->mode == TEST_MODE_COPY)
+		printf("Test   : Copy\n");
+	else if (op->mode == TEST_MODE_MIX)
+		printf("Test   : Mix, Read %d%%, Write %d%%\n",
+			op->fp.mix, 100 - op->fp.mix);
+	else if (op->mode == TEST_MODE_COMMIT)
+		printf("Test   : Commit, %s, %lld records\n",
+			commit_name[op->fp.commit], op->f_len / op->b_len);
+	else if (op->mode == TEST_MODE_META)
+		printf("Test   : Meta, %d files of %lld byte, fanout %d\n",
+			op->meta_files, op->b_len, op->fanout);
+	else if (op->mode == TEST_MODE_REPLAY)
+		printf("Test   : Replay '%s', %d records (%d skipped), %llu.%06llu sec, %s\n",
+			op->trace_file, op->trace.num, op->trace.skipped,
+			SE(op->trace.span / 1000), US(op->trace.span / 1000),
+			op->replay_fast ? "fast" : "trace time");
+	else
+		printf("Test   : Read [%s], Write [%s]\n",
+			op->rd ? "Yes" : "No", op->wr ? "Yes" : "No");
+
+	if (op->rand_file_size)
+		printf("File   : random, min %lld byte, max %lld byte (free %lld Mbyte)\n",
+			op->f_min, op->f_max, op->avail/MBYTE);
+	else
+		printf("File   : %lld byte (free %lld MByte)\n",
+			op->f_len, op->avail/MBYTE);
+
+	if (op->rand_buff_size)
+		printf("Buffer : random, min %lld byte, max %lld byte\n",
+			op->b_min, op->b_max);
+	else
+		printf("Buffer : %lld byte\n", op->b_len);
+
+	printf("Sync   : %s\n", op->fsync ? "Yes" : "No");
+	if (op->fsync && !op->direct)
+		printf("Direct : No\n");
+	printf("Align  : buffer %d byte, offset %d byte\n",
+		op->geo.mem_align, op->geo.off_align);
+	printf("Verify : %s%s\n", op->verify ? verify_name() : "No",
+		op->verify && op->fp.pipeline ? ", pipelined" : "");
+	printf("Time   : %s\n", op->timei ? "Yes" : "No");
+	printf("Count  : %d\n", op->counts);
+	if (op->pool)
+		printf("Pool   : %d files, %lld byte\n",
+			op->counts, op->pool_size);
+	printf("Loop   : %ld\n", op->loop);
+	if (op->fp.dstat)
+		printf("Device : %s\n", op->dstat);
+	else if (op->dstat_shared)
+		printf("Device : %s, shared by parallel jobs, no D lines\n",
+			op->dstat);
+	if (op->arena)
+		printf("Arena  : %s\n", op->arena == ARENA_HUGE ? "hugetlb" :
+			op->arena == ARENA_THP ? "THP" : "Yes");
+	for (i = 0; i < ROLE_NUM; i++) {
+		if (cpu_roles[i].cpus || cpu_roles[i].sched)
+			printf("Role   : %s, cpu %s, sched %s\n", role_name[i],
+				cpu_roles[i].cpus ? cpu_roles[i].cpus : "any",
+				cpu_roles[i].sched ? cpu_roles[i].sched :
+				"inherit");
+	}
+	if (op->sweep)
+		printf("Sweep  : buffer %d - %d byte, %d file lengths\n",
+			SWEEP_MIN, BUFFER_MAX_SIZE, op->sweep_num);
+	if (op->runtime)
+		printf("Runtime: %ld sec\n", op->runtime);
+	if (op->rate_bps || op->rate_iops)
+		printf("Rate   : %llu byte/s, %llu IOPS (0 no limit)\n",
+			op->rate_bps, op->rate_iops);
+	if (op->threads > 1)
+		printf("Thread : %d\n", op->threads);
+	if (op->fp.engine == IO_ENGINE_URING)
+		printf("Engine : %s, depth %d\n",
+			io_engine_name[op->fp.engine], op->fp.depth);
+	if (op->fp.engine == IO_ENGINE_MMAP)
+		printf("Engine : %s%s%s\n", io_engine_name[op->fp.engine],
+			op->fp.populate ? ", populate" : "",
+			op->fp.advise == MADV_SEQUENTIAL ? ", seq" :
+			op->fp.advise == MADV_RANDOM ? ", rand" :
+			op->fp.advise == MADV_WILLNEED ? ", willneed" : "");
+	if (op->fp.random)
+		printf("Access : random\n");
+	if (op->rd && op->fp.cache != FILE_CACHE_SYNC)
+		printf("Cache  : %s\n",
+			op->fp.cache == FILE_CACHE_WARM ? "warm" : "cold");
+	if (op->fp.pat.type == PATTERN_GEN)
+		printf("Data   : rand, compress %d%%, dedup %d%%\n",
+			op->fp.pat.compress, op->fp.pat.dedup);
+	printf("Start  : %d-%d-%d %d:%d:%d\n",
+		tm->tm_year+1900, tm->tm_mon+1, tm->tm_mday,
+		tm->tm_hour, tm->tm_min, tm->tm_sec);
+	printf("===============================================================\n");
+
+	return 0;
+}
+
+/* MB/s spread over all files and loops of the run */
+static void test_summary(struct option_t *op)
+{
+	const char * const *ops = result_ops;
+	struct result_stat st;
+	int i;
+
+	pthread_mutex_lock(&print_lock);
+	for (i = 0; i < RESULT_OPS; i++) {
+		if (results_stat(&op->res, ops[i], &st) || st.num < 2)
+			continue;
+
+		if (op->name)
+			printf("J : %s\n", op->name);
+		printf("S : %c n %d, min %.3f max %.3f mean %.3f stddev %.3f median %.3f M/S\n",
+			ops[i][0] - 'a' + 'A', st.num, st.min, st.max,
+			st.mean, st.stddev, st.median);
+	}
+	fflush(stdout);
+	pthread_mutex_unlock(&print_lock);
+}
+
+/* write the results of all runs, 'ops' are the runs */
+static int test_output(struct option_t *ops, int num)
+{
+	FILE *fp;
+	int i;
+
+	if (ops->json) {
+		fp = fopen(ops->json, "w");
+		if (!fp) {
+			fprintf(stderr, "Fail, open %s (%d)\n",
+				ops->json, errno);
+			return -errno;
+		}
+
+		fputs("{\"runs\": [\n", fp);
+		for (i = 0; i < num; i++) {
+			results_json(fp, ops[i].name, ops[i].disk,
+				     &ops[i].res);
+			fputs(i < num - 1 ? ",\n" : "\n", fp);
+		}
+		fputs("]}\n", fp);
+		fclose(fp);
+	}
+
+	if (ops->csv) {
+		fp = fopen(ops->csv, "w");
+		if (!fp) {
+			fprintf(stderr, "Fail, open %s (%d)\n",
+				ops->csv, errno);
+			return -errno;
+		}
+
+		for (i = 0; i < num; i++)
+			results_csv(fp, ops[i].name, &ops[i].res, !i);
+		fclose(fp);
+	}
+
+	return 0;
+}
+
+/*
+ * check the runs against the --compare baseline, then write --save,
+ * returns the number of regressed ops
+ */
+static int test_baseline(struct option_t *ops, int num)
+{
+	FILE *fp;
+	int i, k, n = 0;
+
+	if (ops->compare) {
+		/* nothing to compare without time info */
+		for (i = 0; i < num; i++) {
+			for (k = 0; k < ops[i].res.num; k++)
+				if (ops[i].res.res[k].usec)
+					break;
+			if (k < ops[i].res.num)
+				break;
+		}
+
+		if (i == num) {
+			fprintf(stderr,
+				"Fail, no timed results to compare with %s\n",
+				ops->compare);
+			return -EINVAL;
+		}
+
+		fp = fopen(ops->compare, "r");
+		if (!fp) {
+			fprintf(stderr, "Fail, open %s (%d)\n",
+				ops->compare, errno);
+			return -errno;
+		}
+
+		pthread_mutex_lock(&print_lock);
+		for (i = 0; i < num; i++)
+			n += results_compare(fp, ops[i].name, &ops[i].res,
+					     ops->tol_mbs, ops->tol_lat,
+					     stdout);
+		printf("G : %s, tolerance M/S %.1f%% latency %.1f%%, %d regression%s\n",
+			ops->compare, ops->tol_mbs, ops->tol_lat, n,
+			n == 1 ? "" : "s");
+		fflush(stdout);
+		pthread_mutex_unlock(&print_lock);
+		fclose(fp);
+	}
+
+	if (ops->save) {
+		fp = fopen(ops->save, "w");
+		if (!fp) {
+			fprintf(stderr, "Fail, open %s (%d)\n",
+				ops->save, errno);
+			return -errno;
+		}
+
+		fputs("# name op mbs p50_ns p99_ns\n", fp);
+		for (i = 0; i < num; i++)
+			results_save(fp, ops[i].name, &ops[i].res);
+		fclose(fp);
+	}
+
+	return n;
+}
+
+/* the smallest buffer within SWEEP_KNEE percent of the best M/S */
+static int sweep_knee(const double *mbs, int num)
+{
+	double best = 0;
+	int i;
+
+	for (i = 0; i < num; i++)
+		if (mbs[i] > best)
+			best = mbs[i];
+
+	for (i = 0; i < num; i++)
+		if (mbs[i] * 100 >= best * SWEEP_KNEE)
+			break;
+
+	return i;
+}
+
+/* one pass of a sweep point, returns M/S and p99 in usec */
+static int sweep_point(struct worker_t *w, const char *file, bool write,
+		       long long f_len, long long b_len,
+		       double *mbs, double *p99)
+{
+	struct option_t *op = w->op;
+	const char *disk = op->geo.blkdev ? NULL : op->disk;
+	struct file_stat st = { .ival = NULL };
+	long long length = 0;
+	u64 time = 0;
+	int ret;
+
+	if (write)
+		ret = test_write(disk, file, op->f_flags, f_len, b_len, &length,
+				 op->counts, op->verify, &time, &op->fp, &st);
+	else
+		ret = test_read(disk, file, op->f_flags, f_len, b_len, &length,
+				op->counts, op->verify, &time, &op->fp, &st);
+	if (ret < 0)
+		return ret;
+
+	test_result(w, 0, write ? "write" : "read", f_len, b_len, length,
+		    time, &st);
+
+	*mbs = time ? (double)length * 1000000.0 / time / MBYTE : 0;
+	*p99 = st.lat.total ? hist_percentile(&st.lat, 99.0) / 1000.0 : 0;
+
+	return 0;
+}
+
+/*
+ * buffer length sweep of the first test file, one write and read pass
+ * per point. 'B :' lines are the curve, 'K :' the knee, above it a
+ * larger request does not pay off any more.
+ */
+static int test_sweep(struct option_t *op)
+{
+	struct worker_t w = { .op = op };
+	double mbs[2][SWEEP_POINTS], p99[2][SWEEP_POINTS];
+	long long b_len[SWEEP_POINTS];
+	char file[256];
+	int i, k, num, ret;
+
+	if (op->geo.blkdev)
+		snprintf(file, sizeof(file), "%s", op->disk);
+	else
+		sprintf(file, "%s/%s.0.txt", op->disk, FILE_PREFIX);
+
+	for (k = 0; k < op->sweep_num; k++) {
+		long long f_len = op->sweep_len[k];
+		struct file_sign sign;
+
+		/* read only sweep, lay out a file of this length once */
+		if (!op->wr && (file_read_sign(file, 0, &sign) < 0 ||
+				sign.f_length != f_len)) {
+			ret = test_write(op->geo.blkdev ? NULL : op->disk,
+					 file, op->f_flags, f_len,
+					 BUFFER_DEF_SIZE, NULL, op->counts,
+					 op->verify, NULL, &op->fp, NULL);
+			if (ret < 0)
+				return ret;
+		}
+
+		num = 0;
+		for (b_len[0] = SWEEP_MIN; num < SWEEP_POINTS &&
+		     b_len[num] <= BUFFER_MAX_SIZE && b_len[num] <= f_len;
+		     num++) {
+			double *wm = &mbs[0][num], *rm = &mbs[1][num];
+
+			*wm = *rm = p99[0][num] = p99[1][num] = 0;
+
+			if (op->wr) {
+				ret = sweep_point(&w, file, true, f_len,
+						  b_len[num], wm, &p99[0][num]);
+				if (ret < 0)
+					return ret;
+			}
+
+			if (op->rd) {
+				ret = sweep_point(&w, file, false, f_len,
+						  b_len[num], rm, &p99[1][num]);
+				if (ret < 0)
+					return ret;
+			}
+
+			printf("B : %lld/%8lld", f_len, b_len[num]);
+			if (op->wr)
+				printf(", W %9.3f M/S p99 %9.1f us",
+					*wm, p99[0][num]);
+			if (op->rd)
+				printf(", R %9.3f M/S p99 %9.1f us",
+					*rm, p99[1][num]);
+			printf("\n");
+			fflush(stdout);
+
+			if (num + 1 < SWEEP_POINTS)
+				b_len[num + 1] = b_len[num] * 2;
+		}
+
+		for (i = 0; i < 2 && num; i++) {
+			const char *name = i ? "R" : "W";
+			int n = sweep_knee(mbs[i], num);
+
+			if ((i ? op->rd : op->wr))
+				printf("K : %lld, %s knee %lld byte, %.3f M/S, p99 %.1f us\n",
+					f_len, name, b_len[n], mbs[i][n],
+					p99[i][n]);
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
+
+/*
+ * buffer requests and page faults of an --arena run, 'a0/r0' at its
+ * start
+ */
+static void test_buffers(struct option_t *op, const struct arena_stat *a0,
+			 const struct rusage *r0)
+{
+	struct arena_stat a;
+	struct rusage r;
+
+	arena_stat(&a);
+	getrusage(RUSAGE_SELF, &r);
+
+	pthread_mutex_lock(&print_lock);
+	if (op->name)
+		printf("J : %s\n", op->name);
+	printf("P : buffers %llu, allocated %llu (saved %llu), pattern kept %llu, arena %llu byte, minor faults %ld\n",
+		a.gets - a0->gets, a.allocs - a0->allocs,
+		(a.gets - a0->gets) - (a.allocs - a0->allocs),
+		a.fills - a0->fills, a.bytes, r.ru_minflt - r0->ru_minflt);
+	fflush(stdout);
+	pthread_mutex_unlock(&print_lock);
+}
+
+static int test_run(struct option_t *op)
+{
+	struct arena_stat a0;
+	struct rusage r0;
+	int count = 0;
+	int ret;
+
+	/* realtime schedule, the workers inherit it */
+	if (op->rt_sched)
+		sched_set_new(0, SCHED_FIFO, 99);
+
+	if (op->sweep)
+		return test_sweep(op);
 
-		if (min && MIN > *min)
-			*min = MIN;
+	arena_stat(&a0);
+	getrusage(RUSAGE_SELF, &r0);
 
-		if (min && MAX < *min)
-			*min = MAX;
+	if (op->runtime)
+		op->work_deadline = time_ns() +
+				    (u64)op->runtime * 1000000000ULL;
 
-		if (max && MIN > *max)
-			*max = MIN;
+	/* time based run loops until the deadline, -l still bounds it */
+	do {
+		ret = test_workers(op, count);
+		if (ret < 0)
+			return ret;
+		count++;
+	} while (op->runtime ? time_ns() < op->work_deadline &&
+			       (!op->loop || count < op->loop) :
+	       count < op->loop);
 
-		if (max && MAX < *max)
-			*max = MAX;
-	} else {
-		/* align with sector size */
-		length = (strtoll(str, NULL, 10) + SECTOR_SIZE - 1) /
-			  SECTOR_SIZE * SECTOR_SIZE;
-	}
+	if (op->arena)
+		test_buffers(op, &a0, &r0);
+	test_summary(op);
 
-	return length;
+	return 0;
 }
 
-static int test_write(const char *disk, const char *file,
-		      ulong f_flags, long long f_length, int b_length,
-		      long long *length, int counts, bool verify, u64 *time)
+static void *test_job(void *data)
 {
-	long long disk_avail;
-	long long size;
+	return (void *)(long)test_run(data);
+}
 
-	/*
-	 * check disk free
-	 */
-	disk_avail = disk_disk_avail(disk, NULL, 0);
-	if (f_length > disk_avail) {
-		int ret = disk_obtain_space(disk, counts, f_length);
+/* yes/no, on/off, 1/0 */
+static int parse_bool(const char *str, bool *val)
+{
+	if (!strcmp(str, "yes") || !strcmp(str, "on") || !strcmp(str, "1"))
+		*val = true;
+	else if (!strcmp(str, "no") || !strcmp(str, "off") ||
+		 !strcmp(str, "0"))
+		*val = false;
+	else
+		return -EINVAL;
 
-		if (ret < 0) {
-			fprintf(stderr,
-				"No space left, free %lld, req %lld\n",
-				disk_disk_avail(disk, NULL, 0), f_length);
-			return -ENOMEM;
-		}
-	}
+	return 0;
+}
 
-	size = file_write(file, f_flags, f_length, b_length,
-			    time, 1, verify);
-	if (size < 0) {
-		fprintf(stderr, "Fail write file, length %lld\n", size);
-		return (int)size;
-	}
+/* one 'key = value' of a job section, the keys follow the options */
+static int job_set(struct option_t *op, const char *key, const char *val)
+{
+	char *v = strdup(val);
+	bool b = false;
 
-	if (length)
-		*length = size;
+	if (!v)
+		return -ENOMEM;
+
+	if (!strcmp(key, "path"))
+		op->disk = v;
+	else if (!strcmp(key, "file"))
+		op->file_size = v;
+	else if (!strcmp(key, "buffer"))
+		op->buff_size = v;
+	else if (!strcmp(key, "count"))
+		op->counts = atoi(v);
+	else if (!strcmp(key, "loop"))
+		op->loop = atoi(v);
+	else if (!strcmp(key, "threads"))
+		op->threads = atoi(v);
+	else if (!strcmp(key, "engine"))
+		return parse_engine(v, &op->fp);
+	else if (!strcmp(key, "depth"))
+		op->fp.depth = atoi(v);
+	else if (!strcmp(key, "mode"))
+		return parse_mode(v, op);
+	else if (!strcmp(key, "pattern"))
+		return parse_pattern(v, &op->fp.pat);
+	else if (!strcmp(key, "runtime"))
+		return (op->runtime = parse_runtime(v)) > 0 ? 0 : -EINVAL;
+	else if (!strcmp(key, "rate"))
+		op->rate_bps = parse_size(v);
+	else if (!strcmp(key, "iops"))
+		op->rate_iops = strtoull(v, NULL, 10);
+	else if (!strcmp(key, "interval"))
+		op->ival_ms = atoi(v);
+	else if (!strcmp(key, "cache"))
+		return parse_cache(v, &op->fp);
+	else if (!strcmp(key, "sweep"))
+		return parse_sweep(strcmp(v, "yes") ? v : NULL, op);
+	else if (!strcmp(key, "fanout"))
+		op->fanout = atoi(v);
+	else if (!strcmp(key, "trace"))
+		op->trace_file = v;
+	else if (parse_bool(v, &b) < 0)
+		return -EINVAL;
+	else if (!strcmp(key, "read"))
+		op->rd = b;
+	else if (!strcmp(key, "write"))
+		op->wr = b;
+	else if (!strcmp(key, "sync"))
+		op->fsync = b, op->direct = b ? op->direct : false;
+	else if (!strcmp(key, "direct"))
+		op->direct = b;
+	else if (!strcmp(key, "verify"))
+		op->verify = b;
+	else if (!strcmp(key, "pipeline"))
+		op->fp.pipeline = b;
+	else if (!strcmp(key, "time"))
+		op->timei = b;
+	else if (!strcmp(key, "pool"))
+		op->pool = b;
+	else
+		return -EINVAL;
 
 	return 0;
 }
 
-static int test_read(const char *disk, const char *file,
-		     ulong f_flags, long long f_length, int b_length,
-		     long long *length, int counts, bool verify, u64 *time)
+static char *job_strip(char *s)
 {
-	long long size;
+	char *e;
 
-	/*
-	 * check exist file
-	 */
-	if (file_read_sign(file, NULL, NULL) < 0) {
-		long long disk_avail = disk_disk_avail(disk, NULL, 0);
+	while (*s == ' ' || *s == '\t')
+		s++;
 
-		if (disk_avail < f_length) {
-			int ret = disk_obtain_space(disk, counts, f_length);
+	e = s + strlen(s);
+	while (e > s && (e[-1] == ' ' || e[-1] == '\t' ||
+			 e[-1] == '\n' || e[-1] == '\r'))
+		*--e = '\0';
 
-			if (ret < 0) {
-				fprintf(stderr,
-					"No space left, free %lld, req %lld\n",
-					disk_disk_avail(disk, NULL, 0),
-					f_length);
-				return ret;
+	return s;
+}
+
+/*
+ * load the sections of an INI job file to 'jobs', every section starts
+ * from 'base' with the [global] keys read so far. returns the number
+ * of sections.
+ */
+static int job_load(const char *file, const struct option_t *base,
+		    struct option_t *jobs, bool *parallel)
+{
+	struct option_t global = *base, *op = &global;
+	char line[512], *key, *val, *p;
+	int num = 0, no = 0;
+	FILE *fp;
+
+	fp = fopen(file, "r");
+	if (!fp) {
+		fprintf(stderr, "Fail, open job %s (%d)\n", file, errno);
+		return -errno;
+	}
+
+	global.job = NULL;
+
+	while (fgets(line, sizeof(line), fp)) {
+		no++;
+		key = job_strip(line);
+		if (!*key || *key == '#' || *key == ';')
+			continue;
+
+		if (*key == '[') {
+			p = strchr(key, ']');
+			if (!p)
+				goto err;
+			*p = '\0';
+			key = job_strip(key + 1);
+
+			if (!strcmp(key, "global")) {
+				op = &global;
+				continue;
+			}
+
+			if (num == JOB_MAX) {
+				fprintf(stderr, "Fail, job %s over %d sections\n",
+					file, JOB_MAX);
+				fclose(fp);
+				return -EINVAL;
 			}
+
+			jobs[num] = global;
+			jobs[num].name = strdup(key);
+			op = &jobs[num++];
+			continue;
 		}
 
-		size = file_write(file, f_flags, f_length, b_length,
-				    NULL, 0, verify);
-		if (size < 0) {
-			fprintf(stderr,
-				"Fail write file to read, length %lld\n", size);
-			return (int)size;
+		p = strchr(key, '=');
+		if (!p)
+			goto err;
+		*p = '\0';
+		val = job_strip(p + 1);
+		key = job_strip(key);
+
+		if (op == &global && !strcmp(key, "run")) {
+			if (strcmp(val, "serial") && strcmp(val, "parallel"))
+				goto err;
+			*parallel = !strcmp(val, "parallel");
+			continue;
 		}
-	}
 
-	/*
-	 * read test
-	 */
-	size = file_read(file, f_flags, f_length, b_length, time, verify);
-	if (size < 0) {
-		fprintf(stderr, "Fail read length %lld\n", size);
-		return (int)size;
+		if (job_set(op, key, val) < 0)
+			goto err;
 	}
 
-	if (length)
-		*length = size;
+	fclose(fp);
 
-	return 0;
+	if (!num)
+		fprintf(stderr, "Fail, no section in job %s\n", file);
+
+	return num;
+
+err:
+	fprintf(stderr, "Fail, job %s:%d '%s'\n", file, no, key);
+	fclose(fp);
+	return -EINVAL;
 }
 
-static void print_usage(void)
+/* sections running at the same time must not share test files */
+static int job_check(struct option_t *jobs, int num)
 {
-	printf("\n");
-	printf("usage: options\n");
-	printf("-p directory path, default current path\n");
-	printf("-r read  option, default read\n");
-	printf("-w write option, default read\n");
-	printf("-b rw buffer len, default %dKbyte (k=Kbyte, m=Mbyte, r=random)\n",
-		BUFFER_DEF_SIZE/MBYTE);
-	printf("   bmin=n, random min, default and limit min  %dbyte\n",
-		BUFFER_MIN_SIZE);
-	printf("   bmax=n, random max, default and limit max %dMbyte\n",
-		BUFFER_MAX_SIZE/MBYTE);
-	printf("-f rw file len, default %dMbyte (k=Kbyte, m=Mbyte, r=random)\n",
-		FILE_DEF_SIZE/MBYTE);
-	printf("   fmin=n, random min, default and limit min %dMbyte\n",
-		FILE_MIN_SIZE/MBYTE);
-	printf("   fmax=n, random max, default and limit max %dMbyte\n",
-		FILE_MAX_SIZE/MBYTE);
-	printf("-c test count, default %d\n", DISK_COUNT);
-	printf("-l loop\n");
-	printf("-s no sync access, default sync\n");
-	printf("-t no time info,\n");
-	printf("-n set priority, FIFO 99\n");
-	printf("-v skip verify\n");
-	printf("\n");
-}
+	char a[256], b[256];
+	int i, j;
 
-/* program options */
-struct option_t {
-	const char *disk;
-	char *buff_size, *file_size;
-	int counts;
-	long loop;
-	bool rd, wr;
-	bool fsync, rt_sched;
-	bool verify, timei;
-} option = {
-	.disk = DISK_PATH,
-	.counts = DISK_COUNT,
-	.rd = false,
-	.wr = false,
-	.loop = 0,
-	.fsync = true,
-	.rt_sched = false,
-	.verify = true,
-	.timei = true,
-};
+	for (i = 0; i < num; i++) {
+		for (j = i + 1; j < num; j++) {
+			if (!realpath(jobs[i].disk, a) ||
+			    !realpath(jobs[j].disk, b) || strcmp(a, b))
+				continue;
 
-static void parse_options(int argc, char **argv, struct option_t *op)
-{
-	int opt;
+			fprintf(stderr,
+				"Fail, job %s and %s share path %s, parallel sections need own paths\n",
+				jobs[i].name, jobs[j].name, a);
+			return -EINVAL;
+		}
+	}
 
-	while (-1 != (opt = getopt(argc, argv, "hrwp:b:f:c:l:stnv"))) {
-		switch (opt) {
-		case 'h':
-			print_usage(); exit(1);
-			break;
-		case 'p':
-			op->disk = optarg;
-			break;
-		case 'r':
-			op->rd = true;
-			break;
-		case 'w':
-			op->wr = true;
-			break;
-		case 'b':
-			op->buff_size = optarg;
-			break;
-		case 'f':
-			op->file_size = optarg;
-			break;
-		case 'c':
-			op->counts = atoi(optarg);
-			break;
-		case 'l':
-			op->loop = atoi(optarg);
-			break;
-		case 's':
-			op->fsync = false;
-			break;
-		case 't':
-			op->timei = false;
-			break;
-		case 'n':
-			op->rt_sched = true;
-			break;
-		case 'v':
-			op->verify = false;
-			break;
-		default:
-			print_usage(), exit(1);
+	/* device counters of a shared device count the other jobs too */
+	for (i = 0; i < num; i++) {
+		for (j = 0; j < num; j++) {
+			if (i == j || !jobs[i].fp.dstat || !jobs[j].dstat[0] ||
+			    strcmp(jobs[i].dstat, jobs[j].dstat))
+				continue;
+
+			jobs[i].fp.dstat = NULL;
+			jobs[i].dstat_shared = true;
 			break;
 		}
 	}
+
+	return 0;
 }
 
 int main(int argc, char **argv)
 {
-	char file[256];
+	static struct option_t jobs[JOB_MAX];
 	struct option_t *op = &option;
-	long long f_min = FILE_MIN_SIZE, f_max = FILE_MAX_SIZE;
-	long long f_len = FILE_DEF_SIZE;
-	long long b_min = BUFFER_MIN_SIZE, b_max = BUFFER_MAX_SIZE;
-	long long b_len = BUFFER_DEF_SIZE;
-
-	ulong f_flags = FILE_O_SYNC | FILE_O_DIRECT;
-	bool rand_file_size = false, rand_buff_size = false;
-	long long disk_avail;
-	struct tm *tm;
-	time_t tt;
-	int i, count = 0;
-	int ret;
+	pthread_t threads[JOB_MAX];
+	bool parallel = false;
+	void *res;
+	int num, i, n, ret = 0;
 
 	parse_options(argc, argv, op);
+	role_apply(ROLE_MAIN);
+	arena_init(op->arena);
 
-	/* get buffer length */
-	b_len = parse_length(argc, argv, op->buff_size,
-			     &b_min, &b_max, "bmin=", "bmax=", &rand_buff_size);
+	srand(time(NULL));
+	verify_init();
+
+	if (op->ival_log) {
+		ival_log = fopen(op->ival_log, "w");
+		if (!ival_log) {
+			fprintf(stderr, "Fail, open %s (%d)\n",
+				op->ival_log, errno);
+			return 1;
+		}
+		fputs("name,op,loop,file,t_us,bytes,mbs,iops,lat_max_ns\n",
+		      ival_log);
 
-	if (!rand_buff_size && b_len > BUFFER_MAX_SIZE) {
-		fprintf(stderr,
-			"Fail, Invalid buffer %lld, max %d byte\n",
-			b_len, BUFFER_MAX_SIZE);
-		print_usage();
-		exit(1);
+		/* a log without period samples every 100 msec */
+		if (!op->ival_ms)
+			op->ival_ms = 100;
 	}
 
-	if (!b_len)
-		b_len = BUFFER_DEF_SIZE;
-
-	f_len = parse_length(argc, argv, op->file_size,
-			     &f_min, &f_max, "fmin=", "fmax=", &rand_file_size);
-
-	if (!f_len)
-		f_len = FILE_DEF_SIZE;
-
-	if (!op->rd && !op->wr)
-		op->rd = true;
-
-	if (!op->fsync)
-		f_flags = 0;
+	if (!op->job) {
+		if (test_setup(op, argc, argv) < 0) {
+			print_usage();
+			return 1;
+		}
 
-	srand(time(NULL));
+		if (test_header(op) < 0)
+			return 1;
 
-	disk_avail = disk_disk_avail(op->disk, NULL, 0);
+		ret = test_run(op);
+		if (test_output(op, 1) < 0 && !ret)
+			ret = 1;
 
-	time(&tt);
-	tm = localtime(&tt);
+		n = test_baseline(op, 1);
+		if (n && !ret)
+			ret = n < 0 ? 1 : BASE_EXIT;
 
-	if (!realpath(op->disk, file)) {
-		fprintf(stderr, "Invalid ditectory path for %s\n", op->disk);
-		return 1;
+		return ret;
 	}
 
-	printf("===============================================================\n");
-	printf("Disk   : '%s'\n", file);
-	printf("Test   : Read [%s], Write [%s]\n",
-		op->rd ? "Yes" : "No", op->wr ? "Yes" : "No");
+	num = job_load(op->job, op, jobs, &parallel);
+	if (num <= 0)
+		return 1;
 
-	if (rand_file_size)
-		printf("File   : random, min %lld byte, max %lld byte (free %lld Mbyte)\n",
-			f_min, f_max, disk_avail/MBYTE);
-	else
-		printf("File   : %lld byte (free %lld MByte)\n", f_len, disk_avail/MBYTE);
+	for (i = 0; i < num; i++) {
+		char **sizes[] = { &jobs[i].buff_size, &jobs[i].file_size };
+		char *args[16], *save, *t;
+		int k;
 
-	if (rand_buff_size)
-		printf("Buffer : random, min %lld byte, max %lld byte\n", b_min, b_max);
-	else
-		printf("Buffer : %lld byte\n", b_len);
+		/*
+		 * 'file = r fmin=4m fmax=20m' is split to words as argv,
+		 * own copies as [global] values are shared by the sections
+		 */
+		for (k = 0, n = 0; k < 2; k++) {
+			if (!*sizes[k])
+				continue;
 
-	printf("Sync   : %s\n", op->fsync ? "Yes" : "No");
-	printf("Time   : %s\n", op->timei ? "Yes" : "No");
-	printf("Count  : %d\n", op->counts);
-	printf("Loop   : %d\n", op->loop);
-	printf("Start  : %d-%d-%d %d:%d:%d\n",
-		tm->tm_year+1900, tm->tm_mon+1, tm->tm_mday,
-		tm->tm_hour, tm->tm_min, tm->tm_sec);
-	printf("===============================================================\n");
+			*sizes[k] = strdup(*sizes[k]);
+			t = strtok_r(*sizes[k], " \t", &save);
+			while (t && n < 16) {
+				args[n++] = t;
+				t = strtok_r(NULL, " \t", &save);
+			}
+		}
 
-	/* realtime schedule */
-	if (op->rt_sched)
-		sched_set_new(getpid(), SCHED_FIFO, 99);
+		if (test_setup(&jobs[i], n, args) < 0) {
+			fprintf(stderr, "Fail, job %s\n", jobs[i].name);
+			return 1;
+		}
+	}
 
-	do {
-		for (i = 0; i < op->counts; i++) {
-			long long length = 0;
-			u64 time = 0, *ptime = op->timei ? &time : NULL;
+	if (parallel && job_check(jobs, num) < 0)
+		return 1;
 
-			if (rand_buff_size)
-				RAND_SIZE(b_min, b_max, SECTOR_SIZE, b_len);
+	for (i = 0; i < num; i++) {
+		if (test_header(&jobs[i]) < 0)
+			return 1;
+	}
 
-			if (rand_file_size)
-				RAND_SIZE(f_min, f_max, f_min, f_len);
+	if (!parallel) {
+		for (i = 0; i < num; i++) {
+			ret = test_run(&jobs[i]);
+			if (ret < 0)
+				break;
+		}
+		goto out;
+	}
 
-			sprintf(file, "%s/%s.%d.txt", op->disk, FILE_PREFIX, i);
-			printf("I : %s, count [%3d/%3d]\n", basename(file), i, count);
+	for (n = 0; n < num; n++) {
+		ret = pthread_create(&threads[n], NULL, test_job, &jobs[n]);
+		if (ret) {
+			fprintf(stderr, "Fail, create job %s (%d)\n",
+				jobs[n].name, ret);
+			ret = -ret;
+			break;
+		}
+	}
 
-			if (op->wr) {
-				ret = test_write(op->disk, file, f_flags,
-						f_len, b_len, &length,
-						op->counts, op->verify, ptime);
-				if (ret < 0)
-					return ret;
+	for (i = 0; i < n; i++) {
+		pthread_join(threads[i], &res);
+		if ((long)res < 0 && !ret)
+			ret = (int)(long)res;
+	}
 
-				printf("W : %3lld.%06lld, %lld/%lld (%3lld.%6lld M/S)\n",
-					time ? SE(time) : 0, time ? US(time) : 0, f_len, b_len,
-					time ? MBS(length, time) : 0, time ? MBU(length, time) : 0);
-			}
+out:
+	/* results of the sections run so far */
+	if (test_output(jobs, num) < 0 && !ret)
+		ret = 1;
 
-			if (op->rd) {
-				ret = test_read(op->disk, file, f_flags,
-						f_len, b_len, &length,
-						op->counts, op->verify, ptime);
-				if (ret < 0)
-					return ret;
-				printf("R : %3lld.%06lld, %lld/%lld (%3lld.%6lld M/S)\n",
-					time ? SE(time) : 0, time ? US(time) : 0, f_len, b_len,
-					time ? MBS(length, time) : 0, time ? MBU(length, time) : 0);
-			}
-			printf("\n");
-		}
-		count++;
-	} while (count < op->loop);
+	n = test_baseline(jobs, num);
+	if (n && !ret)
+		ret = n < 0 ? 1 : BASE_EXIT;
 
-	return 0;
+	return ret;
 }
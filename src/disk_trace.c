@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "disk_trace.h"
+
+static int trace_add(struct trace *t, int *size, const struct trace_rec *r)
+{
+	struct trace_rec *recs;
+
+	if (r->op != 'R' && r->op != 'W' && r->op != 'F') {
+		t->skipped++;
+		return 0;
+	}
+
+	if (t->num == *size) {
+		*size = *size ? *size * 2 : 1024;
+		recs = realloc(t->recs, *size * sizeof(*recs));
+		if (!recs)
+			return -ENOMEM;
+		t->recs = recs;
+	}
+
+	t->recs[t->num++] = *r;
+	if (r->length > t->max_length)
+		t->max_length = r->length;
+
+	return 0;
+}
+
+static int trace_text(FILE *fp, struct trace *t, int *size)
+{
+	char line[256], op[16];
+	struct trace_rec r;
+	double time, lat;
+	int n, no = 0;
+
+	while (fgets(line, sizeof(line), fp)) {
+		no++;
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		lat = 0;
+		n = sscanf(line, "%lf %15s %llu %u %lf", &time, op,
+			   &r.offset, &r.length, &lat);
+		if (n < 4 || time < 0) {
+			fprintf(stderr, "Fail, trace line %d: %s", no, line);
+			return -EINVAL;
+		}
+
+		r.time = (unsigned long long)(time * 1e9);
+		r.op = op[0];
+		r.latency = (unsigned long long)(lat * 1e3);
+
+		if (trace_add(t, size, &r) < 0)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int trace_binary(FILE *fp, struct trace *t, int *size)
+{
+	struct trace_bin b;
+	struct trace_rec r;
+
+	while (fread(&b, sizeof(b), 1, fp) == 1) {
+		r.time = b.time;
+		r.offset = b.offset;
+		r.length = b.length;
+		r.op = (char)b.op;
+		r.latency = b.latency;
+
+		if (trace_add(t, size, &r) < 0)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int trace_cmp(const void *a, const void *b)
+{
+	const struct trace_rec *ra = a, *rb = b;
+
+	return ra->time < rb->time ? -1 : ra->time > rb->time;
+}
+
+int trace_load(const char *file, struct trace *t)
+{
+	char magic[sizeof(TRACE_MAGIC) - 1];
+	int size = 0, ret, i;
+	FILE *fp;
+
+	memset(t, 0, sizeof(*t));
+
+	fp = fopen(file, "r");
+	if (!fp) {
+		fprintf(stderr, "Fail, open trace %s (%d)\n", file, errno);
+		return -errno;
+	}
+
+	if (fread(magic, sizeof(magic), 1, fp) == 1 &&
+	    !memcmp(magic, TRACE_MAGIC, sizeof(magic))) {
+		ret = trace_binary(fp, t, &size);
+	} else {
+		rewind(fp);
+		ret = trace_text(fp, t, &size);
+	}
+	fclose(fp);
+
+	if (!ret && !t->num) {
+		fprintf(stderr, "Fail, no R/W/F record in %s\n", file);
+		ret = -EINVAL;
+	}
+
+	if (ret) {
+		trace_free(t);
+		return ret;
+	}
+
+	/* merged traces of several CPUs, replay in issue order */
+	qsort(t->recs, t->num, sizeof(*t->recs), trace_cmp);
+
+	for (i = t->num - 1; i >= 0; i--)
+		t->recs[i].time -= t->recs[0].time;
+	t->span = t->recs[t->num - 1].time;
+
+	return 0;
+}
+
+void trace_free(struct trace *t)
+{
+	free(t->recs);
+	memset(t, 0, sizeof(*t));
+}
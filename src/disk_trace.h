@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_TRACE_H_
+#define _DISK_TRACE_H_
+
+/*
+ * block I/O trace to replay. a text trace has one record per line,
+ *
+ *   <time sec> <op> <offset byte> <length byte> [<latency usec>]
+ *
+ * op starts with R, W or F (flush), other ops (e.g. D discard) are
+ * skipped, '#' starts a comment. the latency is the traced completion
+ * time (e.g. btt D2C), it is compared with the replay. the dispatch
+ * events of blkparse convert with
+ *
+ *   blkparse -i sda -a issue -f "%T.%9t %d %S %N\n" |
+ *     awk '{ print $1, $2, $3 * 512, $4 }'
+ *
+ * a binary trace starts with TRACE_MAGIC followed by packed little
+ * endian struct trace_bin records.
+ */
+#define	TRACE_MAGIC		"DISKTRC1"
+
+struct trace_bin {
+	unsigned long long time;	/* nsec */
+	unsigned long long offset;
+	unsigned int length;
+	unsigned int op;		/* 'R', 'W' or 'F' */
+	unsigned long long latency;	/* nsec, 0 unknown */
+} __attribute__((packed));
+
+struct trace_rec {
+	unsigned long long time;	/* nsec from the first record */
+	unsigned long long offset;
+	unsigned int length;
+	char op;
+	unsigned long long latency;	/* traced, nsec, 0 unknown */
+};
+
+struct trace {
+	struct trace_rec *recs;
+	int num;
+	int skipped;			/* unknown op records */
+	unsigned int max_length;
+	unsigned long long span;	/* nsec, first to last record */
+};
+
+int trace_load(const char *file, struct trace *t);
+void trace_free(struct trace *t);
+
+#endif /* _DISK_TRACE_H_ */
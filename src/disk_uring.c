@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "disk_uring.h"
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+
+#define	smp_load_acquire(p)	__atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define	smp_store_release(p, v)	__atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+static int sys_uring_setup(unsigned int entries, struct io_uring_params *p)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_uring_enter(int fd, unsigned int submit,
+			   unsigned int complete, unsigned int flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, submit, complete,
+			    flags, NULL, 0);
+}
+
+static int sys_uring_register(int fd, unsigned int opcode, void *arg,
+			      unsigned int nr_args)
+{
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+int uring_init(struct uring *ring, unsigned int entries)
+{
+	struct io_uring_params p;
+	void *ptr;
+
+	memset(ring, 0, sizeof(*ring));
+	memset(&p, 0, sizeof(p));
+
+	ring->fd = sys_uring_setup(entries, &p);
+	if (ring->fd < 0)
+		return -errno;
+
+	ring->entries = p.sq_entries;
+	ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	ring->cq_size = p.cq_off.cqes +
+			p.cq_entries * sizeof(struct io_uring_cqe);
+
+	/* kernel 5.4+ maps both rings with one mmap */
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_size > ring->sq_size)
+			ring->sq_size = ring->cq_size;
+		ring->cq_size = ring->sq_size;
+	}
+
+	ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ptr == MAP_FAILED)
+		goto err_map;
+	ring->sq_ptr = ptr;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ptr = ring->sq_ptr;
+	} else {
+		ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_POPULATE, ring->fd,
+			   IORING_OFF_CQ_RING);
+		if (ptr == MAP_FAILED)
+			goto err_map;
+		ring->cq_ptr = ptr;
+	}
+
+	ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	ptr = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ptr == MAP_FAILED)
+		goto err_map;
+	ring->sqes = ptr;
+
+	ring->sq_head = ring->sq_ptr + p.sq_off.head;
+	ring->sq_tail = ring->sq_ptr + p.sq_off.tail;
+	ring->sq_mask = ring->sq_ptr + p.sq_off.ring_mask;
+	ring->sq_array = ring->sq_ptr + p.sq_off.array;
+
+	ring->cq_head = ring->cq_ptr + p.cq_off.head;
+	ring->cq_tail = ring->cq_ptr + p.cq_off.tail;
+	ring->cq_mask = ring->cq_ptr + p.cq_off.ring_mask;
+	ring->cqes = ring->cq_ptr + p.cq_off.cqes;
+
+	return 0;
+
+err_map:
+	fprintf(stderr, "Fail, io_uring mmap (%d)\n", errno);
+	uring_exit(ring);
+	return -ENOMEM;
+}
+
+void uring_exit(struct uring *ring)
+{
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_size);
+
+	if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_size);
+
+	if (ring->sq_ptr)
+		munmap(ring->sq_ptr, ring->sq_size);
+
+	if (ring->fd >= 0)
+		close(ring->fd);
+
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+}
+
+int uring_probe(struct uring *ring)
+{
+	static const unsigned char ops[] = {
+		IORING_OP_READ, IORING_OP_WRITE,
+	};
+	struct io_uring_probe *probe;
+	size_t len = sizeof(*probe) + 256 * sizeof(probe->ops[0]);
+	int i, ret = 0;
+
+	probe = calloc(1, len);
+	if (!probe)
+		return -ENOMEM;
+
+	/* no probe before kernel 5.6, that has no READ/WRITE either */
+	if (sys_uring_register(ring->fd, IORING_REGISTER_PROBE, probe, 256)) {
+		free(probe);
+		return -EOPNOTSUPP;
+	}
+
+	for (i = 0; i < (int)sizeof(ops); i++) {
+		if (ops[i] > probe->last_op ||
+		    !(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED))
+			ret = -EOPNOTSUPP;
+	}
+	free(probe);
+
+	return ret;
+}
+
+int uring_queue(struct uring *ring, int fd, bool write,
+		void *buf, unsigned int len, long long offset,
+		unsigned long long data)
+{
+	struct io_uring_sqe *sqe;
+	unsigned int tail = *ring->sq_tail;
+	unsigned int index;
+
+	if (tail - smp_load_acquire(ring->sq_head) >= ring->entries)
+		return -EBUSY;
+
+	index = tail & *ring->sq_mask;
+	sqe = (struct io_uring_sqe *)ring->sqes + index;
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = (unsigned long)buf;
+	sqe->len = len;
+	sqe->off = offset;
+	sqe->user_data = data;
+
+	ring->sq_array[index] = index;
+	smp_store_release(ring->sq_tail, tail + 1);
+	ring->inflight++;
+
+	return 0;
+}
+
+int uring_wait(struct uring *ring, unsigned int min)
+{
+	unsigned int submit = *ring->sq_tail - smp_load_acquire(ring->sq_head);
+	int ret;
+
+	do {
+		ret = sys_uring_enter(ring->fd, submit, min,
+				      min ? IORING_ENTER_GETEVENTS : 0);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret < 0 ? -errno : ret;
+}
+
+int uring_reap(struct uring *ring, unsigned long long *data, int *res)
+{
+	struct io_uring_cqe *cqe;
+	unsigned int head = *ring->cq_head;
+
+	if (head == smp_load_acquire(ring->cq_tail))
+		return -EAGAIN;
+
+	cqe = (struct io_uring_cqe *)ring->cqes + (head & *ring->cq_mask);
+	if (data)
+		*data = cqe->user_data;
+	if (res)
+		*res = cqe->res;
+
+	smp_store_release(ring->cq_head, head + 1);
+	ring->inflight--;
+
+	return 0;
+}
+
+#else /* !HAVE_LINUX_IO_URING_H */
+
+int uring_init(struct uring *ring, unsigned int entries)
+{
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+	return -ENOSYS;
+}
+
+void uring_exit(struct uring *ring)
+{
+}
+
+int uring_probe(struct uring *ring)
+{
+	return -ENOSYS;
+}
+
+int uring_queue(struct uring *ring, int fd, bool write,
+		void *buf, unsigned int len, long long offset,
+		unsigned long long data)
+{
+	return -ENOSYS;
+}
+
+int uring_wait(struct uring *ring, unsigned int min)
+{
+	return -ENOSYS;
+}
+
+int uring_reap(struct uring *ring, unsigned long long *data, int *res)
+{
+	return -ENOSYS;
+}
+
+#endif
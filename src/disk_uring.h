@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_URING_H_
+#define _DISK_URING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define	URING_DEF_DEPTH		(1)
+#define	URING_MAX_DEPTH		(256)
+
+/*
+ * minimal io_uring instance over the raw syscalls,
+ * no liburing dependency.
+ */
+struct uring {
+	int fd;
+	unsigned int entries;
+	unsigned int inflight;
+
+	/* submission queue ring */
+	void *sq_ptr;
+	size_t sq_size;
+	unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+	void *sqes;
+	size_t sqes_size;
+
+	/* completion queue ring */
+	void *cq_ptr;
+	size_t cq_size;
+	unsigned int *cq_head, *cq_tail, *cq_mask;
+	void *cqes;
+};
+
+int uring_init(struct uring *ring, unsigned int entries);
+void uring_exit(struct uring *ring);
+
+/* -EOPNOTSUPP when the kernel lacks the read or write opcode */
+int uring_probe(struct uring *ring);
+
+/* queue one read or write, submitted with uring_wait() */
+int uring_queue(struct uring *ring, int fd, bool write,
+		void *buf, unsigned int len, long long offset,
+		unsigned long long data);
+
+/* submit queued requests and wait for 'min' completions */
+int uring_wait(struct uring *ring, unsigned int min);
+
+/* pop one completion, returns -EAGAIN when the ring is empty */
+int uring_reap(struct uring *ring, unsigned long long *data, int *res);
+
+#endif /* _DISK_URING_H_ */
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define	VERIFY_X86
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define	VERIFY_NEON
+#endif
+
+#include "disk_verify.h"
+
+typedef int (*verify_fn)(const unsigned int *, int, unsigned int);
+
+static int verify_scalar(const unsigned int *buf, int words,
+			 unsigned int expect)
+{
+	int i;
+
+	for (i = 0; i < words; i++) {
+		if (buf[i] != expect + i)
+			return i;
+	}
+
+	return -1;
+}
+
+#ifdef VERIFY_X86
+__attribute__((target("sse2")))
+static int verify_sse2(const unsigned int *buf, int words,
+		       unsigned int expect)
+{
+	__m128i e0 = _mm_add_epi32(_mm_set1_epi32((int)expect),
+				   _mm_setr_epi32(0, 1, 2, 3));
+	const __m128i step = _mm_set1_epi32(4);
+	int i = 0, num;
+
+	/* 16 words a round, scalar search only in the failed round */
+	for (; i + 16 <= words; i += 16) {
+		__m128i e1 = _mm_add_epi32(e0, step);
+		__m128i e2 = _mm_add_epi32(e1, step);
+		__m128i e3 = _mm_add_epi32(e2, step);
+		__m128i c;
+
+		c = _mm_and_si128(
+			_mm_and_si128(
+			_mm_cmpeq_epi32(_mm_loadu_si128((void *)&buf[i]), e0),
+			_mm_cmpeq_epi32(_mm_loadu_si128((void *)&buf[i + 4]), e1)),
+			_mm_and_si128(
+			_mm_cmpeq_epi32(_mm_loadu_si128((void *)&buf[i + 8]), e2),
+			_mm_cmpeq_epi32(_mm_loadu_si128((void *)&buf[i + 12]), e3)));
+
+		if (_mm_movemask_epi8(c) != 0xFFFF)
+			break;
+
+		e0 = _mm_add_epi32(e3, step);
+	}
+
+	num = verify_scalar(buf + i, words - i, expect + i);
+
+	return num < 0 ? -1 : i + num;
+}
+
+__attribute__((target("avx2")))
+static int verify_avx2(const unsigned int *buf, int words,
+		       unsigned int expect)
+{
+	__m256i e0 = _mm256_add_epi32(_mm256_set1_epi32((int)expect),
+				      _mm256_setr_epi32(0, 1, 2, 3,
+							4, 5, 6, 7));
+	const __m256i step = _mm256_set1_epi32(8);
+	int i = 0, num;
+
+	/* 32 words a round, scalar search only in the failed round */
+	for (; i + 32 <= words; i += 32) {
+		__m256i e1 = _mm256_add_epi32(e0, step);
+		__m256i e2 = _mm256_add_epi32(e1, step);
+		__m256i e3 = _mm256_add_epi32(e2, step);
+		__m256i c;
+
+		c = _mm256_and_si256(
+			_mm256_and_si256(
+			_mm256_cmpeq_epi32(_mm256_loadu_si256((void *)&buf[i]), e0),
+			_mm256_cmpeq_epi32(_mm256_loadu_si256((void *)&buf[i + 8]), e1)),
+			_mm256_and_si256(
+			_mm256_cmpeq_epi32(_mm256_loadu_si256((void *)&buf[i + 16]), e2),
+			_mm256_cmpeq_epi32(_mm256_loadu_si256((void *)&buf[i + 24]), e3)));
+
+		if (_mm256_movemask_epi8(c) != -1)
+			break;
+
+		e0 = _mm256_add_epi32(e3, step);
+	}
+
+	num = verify_scalar(buf + i, words - i, expect + i);
+
+	return num < 0 ? -1 : i + num;
+}
+#endif
+
+#ifdef VERIFY_NEON
+static int verify_neon(const unsigned int *buf, int words,
+		       unsigned int expect)
+{
+	static const uint32_t seq[4] = { 0, 1, 2, 3 };
+	uint32x4_t e0 = vaddq_u32(vdupq_n_u32(expect), vld1q_u32(seq));
+	const uint32x4_t step = vdupq_n_u32(4);
+	int i = 0, num;
+
+	/* 16 words a round, scalar search only in the failed round */
+	for (; i + 16 <= words; i += 16) {
+		uint32x4_t e1 = vaddq_u32(e0, step);
+		uint32x4_t e2 = vaddq_u32(e1, step);
+		uint32x4_t e3 = vaddq_u32(e2, step);
+		uint32x4_t c;
+		uint32x2_t r;
+
+		c = vandq_u32(vandq_u32(vceqq_u32(vld1q_u32(&buf[i]), e0),
+					vceqq_u32(vld1q_u32(&buf[i + 4]), e1)),
+			      vandq_u32(vceqq_u32(vld1q_u32(&buf[i + 8]), e2),
+					vceqq_u32(vld1q_u32(&buf[i + 12]), e3)));
+
+		r = vand_u32(vget_low_u32(c), vget_high_u32(c));
+		if ((vget_lane_u32(r, 0) & vget_lane_u32(r, 1)) != 0xFFFFFFFF)
+			break;
+
+		e0 = vaddq_u32(e3, step);
+	}
+
+	num = verify_scalar(buf + i, words - i, expect + i);
+
+	return num < 0 ? -1 : i + num;
+}
+#endif
+
+static verify_fn verify_kernel = verify_scalar;
+static const char *verify_kernel_name = "scalar";
+
+void verify_init(void)
+{
+#if defined(VERIFY_X86)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2")) {
+		verify_kernel = verify_avx2;
+		verify_kernel_name = "avx2";
+	} else if (__builtin_cpu_supports("sse2")) {
+		verify_kernel = verify_sse2;
+		verify_kernel_name = "sse2";
+	}
+#elif defined(VERIFY_NEON)
+	verify_kernel = verify_neon;
+	verify_kernel_name = "neon";
+#endif
+}
+
+const char *verify_name(void)
+{
+	return verify_kernel_name;
+}
+
+int verify_seq(const unsigned int *buf, int words, unsigned int expect)
+{
+	return verify_kernel(buf, words, expect);
+}
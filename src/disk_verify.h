@@ -0,0 +1,21 @@
+/*
+ * Copyright (C) 2018  Nexell Co., Ltd.
+ *
+ * Author: junghyun, kim <jhkim@nexell.co.kr>
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef _DISK_VERIFY_H_
+#define _DISK_VERIFY_H_
+
+/* select the compare kernel for this cpu, call once before verify_seq */
+void verify_init(void);
+const char *verify_name(void);
+
+/*
+ * compare 'words' of 'buf' with the sequence 'expect', 'expect + 1', ...
+ * returns index of the first mismatched word or -1.
+ */
+int verify_seq(const unsigned int *buf, int words, unsigned int expect);
+
+#endif /* _DISK_VERIFY_H_ */